@@ -29,6 +29,8 @@ echo.
 echo Limpiando archivos anteriores...
 if exist obj rmdir /s /q obj
 if exist simulador.exe del simulador.exe
+if exist benchmark_db.exe del benchmark_db.exe
+if exist importador_db.exe del importador_db.exe
 
 REM Crear directorio de objetos
 mkdir obj
@@ -59,12 +61,26 @@ echo Enlazando...
 g++ -std=c++17 -pthread obj/*.o -o simulador.exe
 if %errorlevel% neq 0 goto error
 
+REM Benchmarks de la persistencia JSON (ejecutable aparte)
+echo.
+echo Compilando benchmark_db...
+g++ -std=c++17 -Wall -Wextra -pthread -O2 -I./include src/main_benchmark.cpp src/database_json.cpp src/escritor_log.cpp src/io_archivos.cpp src/parser_json.cpp src/archivo_mapeado.cpp src/segmento_columnar.cpp src/database_fragmentada.cpp src/marcas_tiempo.cpp src/serializador_json.cpp src/filtro_bloom.cpp -o benchmark_db.exe
+if %errorlevel% neq 0 goto error
+
+REM Importador de usuarios y transacciones (CSV/JSONL)
+echo.
+echo Compilando importador_db...
+g++ -std=c++17 -Wall -Wextra -pthread -O2 -I./include src/main_importador.cpp src/database_json.cpp src/escritor_log.cpp src/io_archivos.cpp src/parser_json.cpp src/archivo_mapeado.cpp src/segmento_columnar.cpp src/marcas_tiempo.cpp src/serializador_json.cpp src/filtro_bloom.cpp -o importador_db.exe
+if %errorlevel% neq 0 goto error
+
 echo.
 echo ================================================
 echo   COMPILACION EXITOSA
 echo ================================================
 echo.
 echo Ejecutable creado: simulador.exe
+echo Benchmarks de BD:  benchmark_db.exe
+echo Importador de BD:  importador_db.exe
 echo.
 echo Para ejecutar:
 echo   simulador.exe
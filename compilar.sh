@@ -29,7 +29,9 @@ echo "✓ Verificando soporte de C++17..."
 cat > /tmp/test_cpp17.cpp << 'EOF'
 #include <shared_mutex>
 #include <thread>
-int main() { return 0; }
+#include <charconv>
+#include <filesystem>
+int main() { return std::filesystem::exists(".") ? 0 : 1; }
 EOF
 
 if $COMPILADOR -std=c++17 /tmp/test_cpp17.cpp -o /tmp/test_cpp17 2>/dev/null; then
@@ -37,14 +39,14 @@ if $COMPILADOR -std=c++17 /tmp/test_cpp17.cpp -o /tmp/test_cpp17 2>/dev/null; th
     rm -f /tmp/test_cpp17 /tmp/test_cpp17.cpp
 else
     echo "✗ Error: C++17 no soportado"
-    echo "  Actualiza tu compilador a GCC 7+ o Clang 5+"
+    echo "  Actualiza tu compilador a GCC 9+ o Clang 9+"
     exit 1
 fi
 
 # Limpiar compilación anterior
 echo ""
 echo "Limpiando archivos anteriores..."
-rm -rf obj simulador
+rm -rf obj simulador benchmark_db importador_db
 
 # Crear directorio de objetos
 mkdir -p obj
@@ -75,12 +77,26 @@ echo "Enlazando..."
 $COMPILADOR -std=c++17 -pthread obj/*.o -o simulador
 if [ $? -ne 0 ]; then echo "Error en el enlazado"; exit 1; fi
 
+# Benchmarks de la persistencia JSON (ejecutable aparte)
+echo ""
+echo "Compilando benchmark_db..."
+$COMPILADOR -std=c++17 -Wall -Wextra -pthread -O2 -I./include src/main_benchmark.cpp src/database_json.cpp src/escritor_log.cpp src/io_archivos.cpp src/parser_json.cpp src/archivo_mapeado.cpp src/segmento_columnar.cpp src/database_fragmentada.cpp src/marcas_tiempo.cpp src/serializador_json.cpp src/filtro_bloom.cpp -o benchmark_db
+if [ $? -ne 0 ]; then echo "Error compilando benchmark_db"; exit 1; fi
+
+# Importador de usuarios y transacciones (CSV/JSONL)
+echo ""
+echo "Compilando importador_db..."
+$COMPILADOR -std=c++17 -Wall -Wextra -pthread -O2 -I./include src/main_importador.cpp src/database_json.cpp src/escritor_log.cpp src/io_archivos.cpp src/parser_json.cpp src/archivo_mapeado.cpp src/segmento_columnar.cpp src/marcas_tiempo.cpp src/serializador_json.cpp src/filtro_bloom.cpp -o importador_db
+if [ $? -ne 0 ]; then echo "Error compilando importador_db"; exit 1; fi
+
 echo ""
 echo "================================================"
 echo "  ✓ COMPILACIÓN EXITOSA"
 echo "================================================"
 echo ""
 echo "Ejecutable creado: ./simulador"
+echo "Benchmarks de BD:  ./benchmark_db"
+echo "Importador de BD:  ./importador_db"
 echo ""
 echo "Para ejecutar:"
 echo "  ./simulador"
@@ -0,0 +1,36 @@
+#ifndef ARCHIVO_MAPEADO_HPP
+#define ARCHIVO_MAPEADO_HPP
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+// Proyección en memoria de solo lectura de un archivo completo (mmap en
+// POSIX, MapViewOfFile en Windows). Se mapea el tamaño que tenía el archivo
+// al abrirlo: lo que se agregue después no es visible. Un archivo vacío da
+// un contenido vacío.
+class ArchivoMapeado {
+public:
+    explicit ArchivoMapeado(const std::string& ruta);
+    ~ArchivoMapeado();
+    
+    ArchivoMapeado(const ArchivoMapeado&) = delete;
+    ArchivoMapeado& operator=(const ArchivoMapeado&) = delete;
+    
+    bool esta_abierto() const { return abierto; }
+    std::string_view contenido() const { return std::string_view(datos, tamanio); }
+    
+    // Devuelve al sistema las páginas de [0, hasta) ya recorridas; si se
+    // vuelven a leer se recargan desde el archivo
+    void descartar_hasta(size_t hasta) const;
+    
+private:
+    const char* datos = nullptr;
+    size_t tamanio = 0;
+    bool abierto = false;
+#ifdef _WIN32
+    void* mapeo = nullptr;   // HANDLE del objeto de mapeo
+#endif
+};
+
+#endif // ARCHIVO_MAPEADO_HPP
@@ -0,0 +1,113 @@
+#ifndef DATABASE_FRAGMENTADA_HPP
+#define DATABASE_FRAGMENTADA_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <cstdint>
+#include "database_json.hpp"
+#include "escritor_log.hpp"
+
+// Base de datos repartida en N fragmentos, cada uno un DatabaseJSON completo
+// (snapshot, logs, segmentos, hilo de checkpoints) con sus propios archivos:
+// "usuarios_<i>.json" y "transacciones_<i>.json". Un usuario vive en el
+// fragmento que indica el hash de su cuenta_id; cada transacción se guarda
+// en el fragmento de cada usuario que participa.
+//
+// Cada fragmento tiene su mutex de escritura: las operaciones sobre cuentas
+// de fragmentos distintos no se esperan entre sí, y la durabilidad se
+// espera después de soltarlo. Una escritura entre fragmentos deja primero
+// su intención sincronizada en "<transacciones>.pend" y luego toma los dos
+// mutex en orden de índice. Una transferencia escribe el débito en el
+// fragmento del origen y el crédito en el del destino; si el crédito
+// falla, un registro REVERSION devuelve el débito. El arranque revisa las intenciones sin terminar y
+// completa la mitad que falte, sea cual sea la que llegó al disco.
+//
+// Es una clase de biblioteca que se usa por separado (benchmark_db
+// fragmentos): la interfaz gráfica y el simulador siguen con un único
+// DatabaseJSON, y los datos de un DatabaseJSON existente no se reparten.
+// El número de fragmentos de un conjunto de archivos no puede cambiar.
+class DatabaseFragmentada {
+public:
+    explicit DatabaseFragmentada(size_t fragmentos = 4,
+                                 const std::string& archivo_usuarios = "usuarios.json",
+                                 const std::string& archivo_transacciones = "transacciones.json");
+
+    DatabaseFragmentada(const DatabaseFragmentada&) = delete;
+    DatabaseFragmentada& operator=(const DatabaseFragmentada&) = delete;
+
+    size_t cantidad_fragmentos() const { return fragmentos.size(); }
+    // Fragmento en el que se crea un usuario con esta cuenta
+    size_t fragmento_de_cuenta(const std::string& cuenta_id) const;
+    DatabaseJSON& fragmento(size_t indice) { return *fragmentos[indice]->db; }
+
+    // Operaciones de usuarios
+    bool guardar_usuario(const UsuarioDB& usuario);
+    bool actualizar_saldo(const std::string& nombre, double nuevo_saldo);
+    std::vector<UsuarioDB> cargar_usuarios();
+    UsuarioDB obtener_usuario(const std::string& nombre);
+    UsuarioDB obtener_usuario_por_cuenta(const std::string& cuenta_id);
+    bool usuario_existe(const std::string& nombre);
+
+    // Operaciones de transacciones. Los ids son únicos entre fragmentos.
+    int obtener_siguiente_id_transaccion();
+    bool guardar_transaccion(const TransaccionDB& transaccion);
+    bool commit_transferencia(const std::string& origen, const std::string& destino,
+                              double monto, const TransaccionDB& transaccion);
+    // Las transacciones entre fragmentos aparecen una sola vez, en orden de id
+    std::vector<TransaccionDB> cargar_transacciones(int limite = 100);
+    std::vector<TransaccionDB> cargar_transacciones_usuario(const std::string& nombre, int limite = 50);
+
+    // Se aplican a todos los fragmentos; checkpoint() además vacía el
+    // archivo de intenciones si todas están terminadas
+    bool checkpoint();
+    bool flush();
+    bool sincronizar_log();
+    void configurar_durabilidad(ModoDurabilidad modo);
+
+private:
+    struct Fragmento {
+        std::unique_ptr<DatabaseJSON> db;
+        std::mutex mtx;   // Serializa las escrituras del fragmento
+    };
+
+    // Escritura entre fragmentos leída del archivo de intenciones
+    struct Intencion {
+        bool transferencia = false;   // false: copia de una transacción sin saldos
+        TransaccionDB transaccion{};
+        int reversion = 0;            // Id del registro que devuelve el débito, si se anuló
+    };
+
+    std::vector<std::unique_ptr<Fragmento>> fragmentos;
+
+    std::string archivo_intenciones;
+    std::unique_ptr<EscritorLog> intenciones;
+    std::mutex mtx_intenciones;
+    size_t intenciones_abiertas = 0;   // Sin terminar por un error: las resuelve el arranque
+    size_t intenciones_en_curso = 0;   // Registradas y todavía sin cerrar
+
+    // Directorio: en qué fragmento vive cada usuario
+    std::mutex mtx_altas;
+    mutable std::shared_mutex mtx_directorio;
+    std::unordered_map<std::string, size_t> fragmento_por_nombre;
+    std::unordered_map<std::string, size_t> fragmento_por_cuenta;
+
+    static std::string ruta_fragmento(const std::string& ruta, size_t indice);
+    bool buscar_fragmento(const std::string& nombre, size_t& indice) const;
+    bool contiene_transaccion(size_t indice, const std::string& nombre, int id);
+    // Agrega una línea al archivo de intenciones; con 'esperar', vuelve
+    // cuando es durable
+    bool registrar_intencion(const std::string& linea, bool esperar);
+    // Registra y sincroniza una intención que queda en curso hasta
+    // cerrar_intencion(); sin 'terminada' queda abierta para el arranque
+    bool abrir_intencion(const std::string& linea);
+    void cerrar_intencion(int id, bool terminada);
+    // Devuelve el débito de una transferencia cuyo crédito no se escribió
+    bool devolver_debito(size_t indice_origen, const TransaccionDB& transferencia);
+    void resolver_intenciones();
+};
+
+#endif // DATABASE_FRAGMENTADA_HPP
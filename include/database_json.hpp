@@ -2,13 +2,31 @@
 #define DATABASE_JSON_HPP
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
+#include <memory>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <unordered_map>
+#include <unordered_set>
 #include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <atomic>
 #include <fstream>
 #include <sstream>
 #include <iomanip>
 #include <ctime>
+#include <limits>
+#include <optional>
+#include <climits>
+#include <cstdint>
+#include "escritor_log.hpp"
+#include "serializador_json.hpp"
+#include "filtro_bloom.hpp"
 
 struct UsuarioDB {
     std::string nombre;
@@ -27,36 +45,541 @@ struct TransaccionDB {
     std::string fecha;
 };
 
+// Transacción leída en el lugar sobre el log mapeado. Las cadenas son vistas
+// al texto JSON del registro (con sus escapes, si los tiene).
+struct TransaccionVista {
+    int id = 0;
+    std::string_view usuario_origen;
+    std::string_view usuario_destino;
+    double monto = 0.0;
+    std::string_view tipo;
+    bool es_sospechosa = false;
+    std::string_view fecha;
+    bool con_escapes = false;
+    
+    // Copia con dueño, con los escapes ya resueltos
+    TransaccionDB a_transaccion() const;
+};
+
+// Filtros de consultar_transacciones/resumir_transacciones. Se combinan con
+// "y"; los que quedan con su valor por defecto no filtran. Las cadenas son
+// el texto real (sin escapes JSON). Con un período, las transacciones cuya
+// fecha no tiene el formato canónico quedan fuera.
+struct ConsultaTransacciones {
+    std::string usuario;             // Origen o destino
+    std::string origen;
+    std::string destino;
+    std::string tipo;
+    std::optional<bool> es_sospechosa;
+    double monto_minimo = std::numeric_limits<double>::lowest();
+    double monto_maximo = std::numeric_limits<double>::max();
+    int64_t desde = INT64_MIN;       // Fechas en segundos (marcas_tiempo), inclusive
+    int64_t hasta = INT64_MAX;
+    int id_desde = INT_MIN;
+    int id_hasta = INT_MAX;
+};
+
+// Agregados de las transacciones que cumplen una consulta
+struct ResumenTransacciones {
+    size_t cantidad = 0;
+    size_t sospechosas = 0;
+    double suma_montos = 0.0;
+    double monto_minimo = 0.0;       // Con cantidad 0 quedan en 0
+    double monto_maximo = 0.0;
+    
+    double promedio() const { return cantidad ? suma_montos / static_cast<double>(cantidad) : 0.0; }
+};
+
+struct EstadisticasCache {
+    uint64_t aciertos;
+    uint64_t fallos;
+    size_t entradas;
+};
+
+class ArchivoMapeado;
+class SegmentoColumnar;
+struct BloqueDecodificado;
+
+// Segmentos del historial archivado, del más antiguo al más reciente
+using SegmentosArchivo = std::vector<std::shared_ptr<const SegmentoColumnar>>;
+// Bloques de segmento decodificados a los que apuntan vistas en uso
+using BloquesDecodificados = std::vector<std::shared_ptr<const BloqueDecodificado>>;
+
+// Resultado de una lectura analítica: vistas sobre el log mapeado en memoria
+// y sobre los segmentos archivados. Las vistas son válidas mientras viva el
+// historial, que mantiene el mapeo, los segmentos y sus bloques decodificados.
+class HistorialMapeado {
+public:
+    using const_iterator = std::vector<TransaccionVista>::const_iterator;
+    
+    size_t size() const { return registros.size(); }
+    bool empty() const { return registros.empty(); }
+    const TransaccionVista& operator[](size_t i) const { return registros[i]; }
+    const_iterator begin() const { return registros.begin(); }
+    const_iterator end() const { return registros.end(); }
+    
+    // Copias con dueño; con varios hilos, cada uno convierte un tramo
+    std::vector<TransaccionDB> a_transacciones(size_t hilos = 1) const;
+    
+private:
+    friend class DatabaseJSON;
+    std::shared_ptr<const ArchivoMapeado> archivo;
+    SegmentosArchivo segmentos;
+    BloquesDecodificados bloques;
+    std::vector<TransaccionVista> registros;
+};
+
+// Cursor de solo avance: recorre los segmentos archivados y luego el log
+// mapeado, un registro por vez, así que la memoria usada no depende del
+// tamaño del log. Es válido mientras viva el RangoTransacciones del que salió.
+class CursorTransacciones {
+public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = TransaccionVista;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const TransaccionVista*;
+    using reference = const TransaccionVista&;
+    
+    CursorTransacciones() = default;   // Cursor de fin
+    
+    reference operator*() const { return actual; }
+    pointer operator->() const { return &actual; }
+    CursorTransacciones& operator++() { avanzar(); return *this; }
+    
+    bool operator==(const CursorTransacciones& otro) const {
+        return fin == otro.fin &&
+               (fin || (segmento == otro.segmento && fila == otro.fila && siguiente == otro.siguiente));
+    }
+    bool operator!=(const CursorTransacciones& otro) const { return !(*this == otro); }
+    
+private:
+    friend class RangoTransacciones;
+    
+    const SegmentosArchivo* segmentos = nullptr;
+    size_t segmento = 0;         // Segmento en curso; al agotarlos se sigue por el log
+    size_t fila = 0;             // Fila que sigue a 'actual' dentro del segmento
+    // Bloque en curso, decodificado solo para este cursor: el recorrido no
+    // pasa por la caché de bloques ni la desaloja
+    std::shared_ptr<const BloqueDecodificado> bloque;
+    const ArchivoMapeado* archivo = nullptr;
+    std::string_view contenido;
+    size_t siguiente = 0;        // Inicio de la línea que sigue a 'actual'
+    size_t descartado = 0;       // Prefijo del mapeo ya devuelto al sistema
+    TransaccionVista actual;
+    bool fin = true;
+    
+    void avanzar();
+};
+
+// Historial completo recorrido en streaming: for (const auto& t : rango)
+class RangoTransacciones {
+public:
+    CursorTransacciones begin() const;
+    CursorTransacciones end() const { return CursorTransacciones(); }
+    
+private:
+    friend class DatabaseJSON;
+    SegmentosArchivo segmentos;
+    std::shared_ptr<const ArchivoMapeado> archivo;
+    size_t inicio_log = 0;       // Bytes iniciales del log ya incluidos en los segmentos
+};
+
+// Versión inmutable de la tabla de usuarios. Los lectores toman la vigente
+// sin bloquear (version_usuarios()) y la consultan aunque haya commits en
+// curso; cada escritura publica una versión nueva que copia solo las páginas
+// de usuarios que cambian y comparte el resto. Los índices también se
+// comparten: las altas van a unos índices chicos de altas recientes, que se
+// funden con los completos cuando pasan de ~raíz cuadrada de la tabla. Las
+// búsquedas de nombres y cuentas que no existen las descarta un filtro de
+// Bloom sin tocar los índices.
+class VersionUsuarios {
+public:
+    size_t size() const { return cantidad; }
+    const UsuarioDB& operator[](size_t i) const { return (*paginas[i / TAM_PAGINA])[i % TAM_PAGINA]; }
+    uint64_t numero() const { return version; }
+    
+    // nullptr si no existe
+    const UsuarioDB* buscar_nombre(const std::string& nombre) const;
+    const UsuarioDB* buscar_cuenta(const std::string& cuenta_id) const;
+    std::vector<UsuarioDB> a_vector() const;
+    
+private:
+    friend class DatabaseJSON;
+    static constexpr size_t TAM_PAGINA = 64;
+    using Indice = std::unordered_map<std::string, size_t>;
+    
+    std::vector<std::shared_ptr<const std::vector<UsuarioDB>>> paginas;
+    std::shared_ptr<const Indice> indice_nombre = std::make_shared<const Indice>();
+    std::shared_ptr<const Indice> indice_cuenta = std::make_shared<const Indice>();
+    // Altas posteriores a los índices de arriba, hasta que se funden con ellos
+    std::shared_ptr<const Indice> recientes_nombre = std::make_shared<const Indice>();
+    std::shared_ptr<const Indice> recientes_cuenta = std::make_shared<const Indice>();
+    // Compartidos con DatabaseJSON, que los sigue completando: pueden tener
+    // claves de versiones posteriores, que el índice termina de descartar
+    std::shared_ptr<const FiltroBloom> filtro_nombres;
+    std::shared_ptr<const FiltroBloom> filtro_cuentas;
+    size_t cantidad = 0;
+    uint64_t version = 0;
+    
+    // Posición de 'clave' en el índice o en sus altas recientes (que son
+    // posteriores: ante cuentas repetidas gana el índice); nullptr si no está
+    static const size_t* buscar(const Indice& indice, const Indice& recientes, const std::string& clave);
+};
+
 class DatabaseJSON {
+public:
+    // Escritura ya aplicada y agregada al log cuya durabilidad no se esperó.
+    // Las escrituras de DatabaseJSON que reciben 'pendiente' lo completan y vuelven
+    // sin esperar: el llamador la espera con esperar_commit() después de
+    // soltar sus propios locks (DatabaseFragmentada).
+    struct CommitPendiente {
+        EscritorLog* escritor = nullptr;   // nullptr: nada que esperar
+        EscritorLog::Ticket ticket;
+    };
+    
 private:
-    std::string archivo_usuarios;
-    std::string archivo_transacciones;
+    friend class CursorTransacciones;
+    
+    // Registro del log: una transacción y, en las transferencias, los saldos
+    // resultantes de ambos usuarios. El lsn ordena todos los registros.
+    struct RegistroLog {
+        uint64_t lsn = 0;
+        TransaccionDB transaccion{};
+        bool con_saldos = false;
+        double saldo_origen = 0.0;
+        double saldo_destino = 0.0;
+    };
+    
+    // Registro del log de usuarios: el alta de un usuario o su nuevo saldo
+    struct RegistroSaldo {
+        uint64_t lsn = 0;
+        bool alta = false;
+        UsuarioDB usuario{};
+    };
+    
+    // Lo que necesita un lector del historial para no tomar mtx. Se publica
+    // una nueva al archivar y al abrir los logs.
+    struct VersionHistorial {
+        SegmentosArchivo segmentos;
+        std::shared_ptr<EscritorLog> escritor;
+        uint64_t inicio_log = 0;   // Bytes iniciales del log ya incluidos en los segmentos
+    };
+    
+    std::string archivo_usuarios;            // Snapshot de usuarios (último checkpoint)
+    std::string archivo_log_usuarios;        // Deltas de usuarios posteriores al snapshot
+    std::string archivo_checkpoint;          // lsn y offset del log cubiertos por el snapshot
+    std::string archivo_transacciones;       // Exportación en formato de arreglo JSON
+    std::string archivo_log_transacciones;   // Log append-only (fuente de verdad)
+    std::string archivo_indice_usuarios;     // Índice usuario -> offsets en el log
+    std::string archivo_secuencia_ids;       // Techo persistido del asignador de ids
+    std::string prefijo_segmentos;           // Segmentos archivados: <prefijo><número>
     mutable std::mutex mtx;
     
+    // Tabla de usuarios residente, indexada por nombre y por cuenta. La
+    // modifican los escritores con mtx tomado; los lectores usan la versión
+    // publicada, que se actualiza después de cada cambio.
+    std::vector<UsuarioDB> usuarios;
+    std::unordered_map<std::string, size_t> indice_nombre;
+    std::unordered_map<std::string, size_t> indice_cuenta;
+    // Filtros de Bloom sobre las claves de los índices. Cada alta se agrega
+    // en el lugar; al llenarse se rehacen con el doble de capacidad.
+    std::shared_ptr<FiltroBloom> filtro_nombres;
+    std::shared_ptr<FiltroBloom> filtro_cuentas;
+    std::vector<uint64_t> lsn_usuarios;   // Último lsn reflejado en cada usuario
+    uint64_t ultimo_lsn = 0;              // Último lsn escrito en el log
+    uint64_t tam_log = 0;                 // Bytes válidos del log
+    uint64_t cambios_historial = 0;       // Appends al log de transacciones
+    uint64_t cambios_exportados = 0;      // Los que cubre la última exportación a transacciones.json
+    bool exportar_al_cerrar = false;
+    std::shared_ptr<const VersionUsuarios> usuarios_publicados = std::make_shared<const VersionUsuarios>();
+    std::shared_ptr<const VersionHistorial> historial_publicado = std::make_shared<const VersionHistorial>();
+    
+    // Índice secundario persistente: usuario (origen o destino) -> offsets.
+    // Su propio mutex, para que las lecturas por usuario no esperen a mtx.
+    std::mutex mtx_indice;
+    std::unordered_map<std::string, std::vector<uint64_t>> offsets_por_usuario;
+    uint64_t fin_indexado = 0;            // Offset del último registro indexado + 1
+    
+    // Índice temporal disperso del log (también bajo mtx_indice): un tramo
+    // cada REGISTROS_POR_TRAMO registros, con el rango de sus fechas en
+    // segundos. Se reconstruye con el índice por usuario.
+    struct TramoTiempo {
+        uint64_t offset;              // Primer registro del tramo
+        int64_t desde;                // Rango de fechas canónicas (desde > hasta: ninguna)
+        int64_t hasta;
+        int64_t maximo_acumulado;     // Mayor 'hasta' de este tramo y los anteriores
+        uint32_t registros;
+    };
+    static constexpr uint32_t REGISTROS_POR_TRAMO = 256;
+    std::vector<TramoTiempo> tramos_tiempo;
+    
+    // Historial archivado en segmentos por columnas (inmutables)
+    SegmentosArchivo segmentos;
+    size_t siguiente_segmento = 1;
+    uint64_t umbral_archivado = 64ull * 1024 * 1024;   // Bytes del log que disparan el archivado
+    
+    // Hilos de las lecturas completas del historial (0: uno por núcleo)
+    std::atomic<size_t> hilos_carga{0};
+    
+    // Asignador de ids: se persiste un techo por bloques y se reparte en memoria
+    static constexpr int TAM_BLOQUE_IDS = 1024;
+    static constexpr size_t COLA_RECUPERACION_IDS = 256;
+    mutable std::mutex mtx_ids;
+    int siguiente_id = 1;
+    int techo_ids = 0;
+    
+    // Escritores de los logs con group commit y política de durabilidad
+    std::shared_ptr<EscritorLog> escritor_log;   // Compartido con los lectores
+    std::unique_ptr<EscritorLog> escritor_usuarios;
+    ModoDurabilidad modo_durabilidad = ModoDurabilidad::GRUPO;
+    
+    // Checkpoint en segundo plano: escribe el snapshot de usuarios y vacía su log
+    std::thread hilo_checkpoint;
+    std::condition_variable cv_checkpoint;
+    std::chrono::milliseconds intervalo_checkpoint{5000};
+    size_t umbral_checkpoint = 1000;      // Cambios que adelantan el checkpoint
+    size_t cambios_sin_checkpoint = 0;    // Registros con saldos desde el último snapshot
+    bool detener_checkpoint = false;
+    
+    // Escritura diferida de saldos (opcional): actualizar_saldo solo marca al
+    // usuario y el hilo de checkpoints escribe un delta por usuario marcado,
+    // con su último saldo, al vencer el intervalo o al juntar 'umbral_volcado'
+    std::unordered_set<size_t> saldos_sucios;
+    std::chrono::steady_clock::time_point primer_sucio;   // Cambio más antiguo sin volcar
+    std::chrono::milliseconds intervalo_volcado{0};       // 0: escritura inmediata
+    size_t umbral_volcado = 256;
+    
+    // Buffer de los registros que van a los logs (se usa con mtx tomado)
+    SerializadorJSON serializador;
+    
+    // Caché de las lecturas recientes por (consulta, límite). Cada cambio
+    // que los lectores ya pueden ver incrementa version_datos; una entrada
+    // solo se usa mientras su versión sea la vigente.
+    struct EntradaCache {
+        uint64_t version;
+        std::shared_ptr<const std::vector<TransaccionDB>> transacciones;
+    };
+    static constexpr int LIMITE_CACHE = 10000;   // Lecturas más largas no se guardan
+    std::atomic<uint64_t> version_datos{0};
+    std::mutex mtx_cache;
+    std::map<std::pair<std::string, int>, EntradaCache> cache_lecturas;
+    size_t capacidad_cache = 64;                 // Entradas (0: sin caché)
+    uint64_t aciertos_cache = 0;
+    uint64_t fallos_cache = 0;
+    
     std::string obtener_fecha_actual();
     std::string escapar_json(const std::string& str);
-    std::string trim(const std::string& str);
+    
+    // Log de transacciones: un registro JSON por línea con cabecera longitud/CRC32.
+    // serializar_* agregan el registro ya enmarcado al final de 'destino'.
+    static void serializar_registro(const RegistroLog& registro, SerializadorJSON& destino);
+    bool parsear_transaccion(std::string_view json, TransaccionDB& t);
+    bool parsear_registro(std::string_view json, RegistroLog& registro);
+    bool agregar_al_log(const RegistroLog& registro, EscritorLog::Ticket& ticket);
+    // Agrega el registro al índice por usuario y al temporal ('segundos':
+    // su fecha o marcas_tiempo::SIN_FECHA)
+    void indexar_registro(uint64_t offset, const TransaccionDB& t, int64_t segundos, bool persistir);
+    static void agregar_linea_indice(std::string& destino, uint64_t offset,
+                                     const TransaccionDB& t, int64_t segundos);
+    void escribir_lineas_indice(const std::string& lineas);
+    void cargar_indice_usuarios();
+    bool avanzar_secuencia_ids(int id_usado);
+    bool persistir_techo_ids(int techo);
+    void recuperar_secuencia_ids();
+    static bool desenmarcar_registro(std::string_view linea, std::string_view& json);
+    std::shared_ptr<const ArchivoMapeado> mapear_log();
+    static HistorialMapeado leer_historial(SegmentosArchivo segmentos,
+                                           std::shared_ptr<const ArchivoMapeado> log, size_t inicio_log,
+                                           size_t limite, size_t hilos = 1);
+    // Sin tomar mtx: segmentos y log mapeado de una misma versión del
+    // historial. 'durante' corre dentro de esa ventana.
+    void tomar_historial(SegmentosArchivo& archivados, std::shared_ptr<const ArchivoMapeado>& log,
+                         size_t& inicio_log, const std::function<void()>& durante = nullptr);
+    void publicar_historial(uint64_t inicio_log);
+    size_t hilos_de_carga() const;
+    // Devuelve la entrada vigente de (consulta, limite) o la arma con leer()
+    std::vector<TransaccionDB> leer_con_cache(const std::string& consulta, int limite,
+                                              const std::function<std::vector<TransaccionDB>()>& leer);
+    std::vector<TransaccionDB> cargar_transacciones_legado();
+    uint64_t recuperar_log(const std::string& ruta, uint64_t desde,
+                           const std::function<void(std::string_view)>& visitar);
+    void recuperar_log_transacciones(std::vector<RegistroSaldo>& cambios);
+    void limpiar_temporales();
+    
+    // Archivado del log en segmentos por columnas
+    std::string ruta_segmento(size_t numero) const;
+    // (número, ruta) de los segmentos en disco, en orden
+    std::vector<std::pair<size_t, std::string>> listar_segmentos() const;
+    void cargar_segmentos();
+    void completar_archivado();
+    size_t archivar_sin_lock();
+    
+    // Usuarios: snapshot + log de deltas, compactado por checkpoints
+    static void serializar_saldo(const RegistroSaldo& registro, SerializadorJSON& destino);
+    bool parsear_saldo(std::string_view json, RegistroSaldo& registro);
+    bool agregar_al_log_usuarios(const RegistroSaldo& registro, EscritorLog::Ticket& ticket);
+    size_t aplicar_cambio_usuario(const RegistroSaldo& registro);
+    void recuperar_log_usuarios(std::vector<RegistroSaldo>& cambios);
+    void leer_checkpoint(uint64_t& lsn, uint64_t& offset);
+    void registrar_cambio_sin_checkpoint();
+    bool checkpoint_sin_lock();
+    void ejecutar_checkpoints();
+    // Escribe en el log de usuarios los saldos marcados; 'ticket' es el del
+    // último delta (vale por todos) y 'volcados' cuántos se escribieron
+    bool volcar_saldos_sin_lock(EscritorLog::Ticket& ticket, size_t& volcados);
+    std::vector<UsuarioDB> cargar_usuarios_archivo(std::vector<uint64_t>& lsns);
+    void indexar_usuario(size_t posicion);
+    void rehacer_filtros(size_t capacidad);
+    // Publica para los lectores una versión con los usuarios 'cambiados'
+    // (y las altas) al día
+    void publicar_usuarios(std::initializer_list<size_t> cambiados);
+    bool escribir_usuarios();
+    bool escribir_movimiento(const std::string& local, double delta, const TransaccionDB& transaccion,
+                             bool validar_saldo, CommitPendiente* pendiente);
+    // Suelta 'lock' y espera 'ticket' de 'escritor', o lo deja en 'pendiente'
+    static bool terminar_commit(std::unique_lock<std::mutex>& lock, EscritorLog& escritor,
+                                const EscritorLog::Ticket& ticket, CommitPendiente* pendiente);
     
 public:
     DatabaseJSON(const std::string& archivo_usuarios = "usuarios.json", 
                  const std::string& archivo_transacciones = "transacciones.json");
+    ~DatabaseJSON();
+    
+    // true cuando 'pendiente' es durable según el modo de durabilidad
+    bool esperar_commit(const CommitPendiente& pendiente);
     
     // Operaciones de usuarios
-    bool guardar_usuario(const UsuarioDB& usuario);
-    bool actualizar_saldo(const std::string& nombre, double nuevo_saldo);
+    bool guardar_usuario(const UsuarioDB& usuario, CommitPendiente* pendiente = nullptr);
+    // Alta masiva: un lock, appends de ~1 MiB y una sola espera de durabilidad.
+    // Se saltan los nombres que ya existen o se repiten en el lote (queda el
+    // primero). Devuelve cuántos se aplicaron; si falla una escritura, los
+    // que quedaron antes de ella. Si falla la espera de durabilidad, los
+    // aplicados se cuentan igual y se avisa por std::cerr.
+    size_t guardar_usuarios_lote(const std::vector<UsuarioDB>& lote);
+    // true cuando el nuevo saldo es durable; con escritura diferida, apenas
+    // queda visible (ver configurar_escritura_diferida)
+    bool actualizar_saldo(const std::string& nombre, double nuevo_saldo,
+                          CommitPendiente* pendiente = nullptr);
     std::vector<UsuarioDB> cargar_usuarios();
+    // Versión vigente de la tabla, sin bloquear ni copiar
+    std::shared_ptr<const VersionUsuarios> version_usuarios() const;
     UsuarioDB obtener_usuario(const std::string& nombre);
     UsuarioDB obtener_usuario_por_cuenta(const std::string& cuenta_id);
     bool usuario_existe(const std::string& nombre);
     
     // Operaciones de transacciones
-    bool guardar_transaccion(const TransaccionDB& transaccion);
+    bool guardar_transaccion(const TransaccionDB& transaccion, CommitPendiente* pendiente = nullptr);
+    // Carga masiva con las mismas reglas que guardar_usuarios_lote. Las
+    // filas con id 0 reciben ids nuevos de la secuencia; un id propio que no
+    // supera a los ya entregados (guardados, reservados o anteriores en el
+    // lote) se salta
+    size_t guardar_transacciones_lote(const std::vector<TransaccionDB>& lote);
+    // Transferencia atómica: ambos saldos y la transacción en una sola escritura
+    bool commit_transferencia(const std::string& origen, const std::string& destino,
+                              double monto, const TransaccionDB& transaccion,
+                              CommitPendiente* pendiente = nullptr);
+    // Una mitad de una transferencia entre dos bases (DatabaseFragmentada):
+    // 'local', el origen o el destino de 'transaccion', es el único de los
+    // dos que vive en esta base y su saldo cambia en 'delta'. Se registra
+    // como una transferencia; al recuperar solo se aplica el saldo local.
+    bool commit_movimiento(const std::string& local, double delta, const TransaccionDB& transaccion,
+                           CommitPendiente* pendiente = nullptr);
+    // Como commit_movimiento pero sin validar el saldo: solo para completar
+    // al arrancar una transferencia ya aceptada cuya otra mitad es durable.
+    // El saldo puede quedar negativo.
+    bool completar_movimiento(const std::string& local, double delta, const TransaccionDB& transaccion);
     std::vector<TransaccionDB> cargar_transacciones(int limite = 100);
     std::vector<TransaccionDB> cargar_transacciones_usuario(const std::string& nombre, int limite = 50);
+    // Lecturas analíticas sin copias: el log se mapea y se parsea en el lugar
+    HistorialMapeado mapear_transacciones(int limite = 0);
+    HistorialMapeado mapear_transacciones_usuario(const std::string& nombre, int limite = 0);
+    // Transacciones con id en [id_desde, id_hasta], en orden de archivo. Del
+    // historial archivado solo se leen los bloques que contienen ese rango.
+    std::vector<TransaccionDB> cargar_transacciones_rango(int id_desde, int id_hasta);
+    HistorialMapeado mapear_transacciones_rango(int id_desde, int id_hasta);
+    // Transacciones con fecha en [desde, hasta] ("AAAA-MM-DD hh:mm:ss"), en
+    // orden de archivo. Los índices temporales de los segmentos y del log
+    // llevan directo a los bloques y tramos que pueden contenerlas.
+    std::vector<TransaccionDB> cargar_transacciones_periodo(const std::string& desde, const std::string& hasta);
+    // Lo mismo con los extremos en segundos (marcas_tiempo::a_segundos)
+    HistorialMapeado mapear_transacciones_periodo(int64_t desde, int64_t hasta);
+    // Las lecturas completas (limite = 0) parsean el log por tramos en paralelo
+    void configurar_hilos_carga(size_t hilos);
+    // cargar_transacciones y cargar_transacciones_usuario con límite se
+    // guardan por (consulta, límite) y, mientras nada cambie, se repiten
+    // desde memoria. Cualquier escritura las invalida a todas. 0 entradas
+    // desactiva la caché.
+    void configurar_cache(size_t entradas);
+    EstadisticasCache obtener_estadisticas_cache();
+    // Crece con cada cambio visible para los lectores (transacciones, altas, saldos)
+    uint64_t obtener_version_datos() const;
+    // Recorrido en streaming, en orden del log, con memoria constante
+    RangoTransacciones recorrer_transacciones();
+    // Visita los registros que cumplen 'predicado' (nullptr: todos) hasta que
+    // 'visitar' devuelva false. Devuelve cuántos registros se visitaron.
+    size_t for_each_transaccion(const std::function<bool(const TransaccionVista&)>& predicado,
+                                const std::function<bool(const TransaccionVista&)>& visitar);
+    // Consulta con los filtros evaluados durante la lectura: en el log, un
+    // registro se descarta en cuanto un campo no cumple (o antes de parsearlo,
+    // si no contiene el usuario o el tipo pedido); en los segmentos, sobre las
+    // columnas, sin armar la vista. El usuario y el período usan los índices.
+    // Visita las que cumplen, en orden de archivo, hasta que 'visitar'
+    // devuelva false; devuelve cuántas visitó.
+    size_t consultar_transacciones(const ConsultaTransacciones& consulta,
+                                   const std::function<bool(const TransaccionVista&)>& visitar);
+    // Cantidad, suma, mínimo, máximo y sospechosas, sin armar ningún vector
+    ResumenTransacciones resumir_transacciones(const ConsultaTransacciones& consulta);
     int obtener_siguiente_id_transaccion();
+    // El id que entregaría obtener_siguiente_id_transaccion(), sin reservarlo
+    int consultar_siguiente_id() const;
+    // Reserva 'cantidad' ids consecutivos y devuelve el primero, o -1 si no
+    // se pudo persistir el techo de la secuencia (no se entrega ningún id)
+    int reservar_ids(int cantidad);
+    bool exportar_transacciones_json(const std::string& destino = "");
+    // Regenerar transacciones.json en el destructor si el historial cambió
+    // desde la última exportación (desactivado: recorre todo el historial)
+    void configurar_exportacion_al_cerrar(bool activar);
+    
+    // Durabilidad de los commits (por defecto, group commit)
+    void configurar_durabilidad(ModoDurabilidad modo);
+    ModoDurabilidad obtener_durabilidad() const;
+    EstadisticasCommit obtener_estadisticas_commit(ModoDurabilidad modo) const;
+    void reiniciar_estadisticas_commit();
+    bool sincronizar_log();
+    
+    // Snapshot de usuarios: periódico en segundo plano o forzado con checkpoint()
+    bool checkpoint();
+    void configurar_checkpoint(std::chrono::milliseconds intervalo, size_t umbral_cambios);
+    
+    // Saldos con escritura diferida, desactivada por defecto: actualizar_saldo()
+    // se ve al instante y llega al log a lo sumo 'intervalo' después (antes si
+    // se juntan 'umbral_sucios' usuarios). Mientras está activa, su true ya no
+    // significa que el saldo sea durable: ante una caída se pierde lo del
+    // último intervalo. flush() lo escribe ya y espera su durabilidad. Un
+    // intervalo de 0 vuelve a la escritura inmediata.
+    bool flush();
+    void configurar_escritura_diferida(std::chrono::milliseconds intervalo, size_t umbral_sucios);
+    
+    // Archivado: el log cubierto por el checkpoint pasa a un segmento por
+    // columnas. Lo hace el hilo de checkpoints al superar el umbral (0: nunca)
+    // o se fuerza con archivar_transacciones(). Devuelve los registros archivados.
+    size_t archivar_transacciones();
+    void configurar_archivado(uint64_t umbral_bytes_log);
+    
+    // Parseo en una pasada de los archivos en formato de arreglo JSON
+    // (cualquier espaciado, también minificado)
+    static bool parsear_usuarios_json(std::string_view texto, std::vector<UsuarioDB>& destino,
+                                      std::vector<uint64_t>* lsns = nullptr);
+    static bool parsear_transacciones_json(std::string_view texto,
+                                           std::vector<TransaccionDB>& destino);
     
     // Utilidades
     void inicializar_archivos();
+    // Backup consistente en <directorio>/backup_<fecha>, que se abre como una
+    // base más. Copia el snapshot de usuarios y la cola del log; los segmentos
+    // archivados se guardan una sola vez en <directorio>/segmentos/<log>, un
+    // almacén por base, y cada backup los enlaza (enlace duro, o copia si no
+    // se puede).
     bool exportar_backup(const std::string& directorio);
 };
 
@@ -0,0 +1,114 @@
+#ifndef ESCRITOR_LOG_HPP
+#define ESCRITOR_LOG_HPP
+
+#include <string>
+#include <string_view>
+#include <array>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+
+// Política de durabilidad de los commits del log
+enum class ModoDurabilidad {
+    NINGUNA,     // write() sin fsync: lo sincroniza el sistema operativo cuando quiere
+    ASINCRONA,   // write() inmediato; el hilo escritor hace fsync periódicamente
+    GRUPO,       // Group commit: un write + fsync por lote; el commit espera al fsync
+    POR_COMMIT   // write + fsync en cada commit
+};
+
+const char* nombre_modo_durabilidad(ModoDurabilidad modo);
+
+// Latencia y throughput de los commits hechos en un modo
+struct EstadisticasCommit {
+    ModoDurabilidad modo;
+    uint64_t commits;
+    uint64_t lotes;
+    uint64_t fsyncs;
+    uint64_t bytes;
+    double latencia_media_us;
+    double latencia_max_us;
+    double commits_por_segundo;
+};
+
+// Escritor append-only de un archivo de log con group commit.
+// agregar() se llama con el lock del dueño tomado (fija el orden de los
+// registros); esperar_durable() se llama después de soltarlo, para que otros
+// committers puedan sumarse al mismo lote mientras se hace el fsync.
+class EscritorLog {
+public:
+    struct Ticket {
+        uint64_t secuencia = 0;
+        bool esperar = false;
+        ModoDurabilidad modo = ModoDurabilidad::NINGUNA;
+        std::chrono::steady_clock::time_point inicio;
+    };
+
+    EscritorLog(const std::string& ruta, ModoDurabilidad modo = ModoDurabilidad::GRUPO);
+    ~EscritorLog();
+
+    EscritorLog(const EscritorLog&) = delete;
+    EscritorLog& operator=(const EscritorLog&) = delete;
+
+    bool esta_abierto() const;
+
+    // Encola o escribe 'datos' según el modo. Devuelve false si falló la escritura.
+    bool agregar(std::string_view datos, Ticket& ticket);
+
+    // Bloquea hasta que el ticket sea durable según su modo y registra su latencia
+    bool esperar_durable(const Ticket& ticket);
+
+    // Lleva al archivo lo encolado (sin fsync) para que los lectores lo vean
+    bool escribir_pendientes();
+
+    // Fuerza write + fsync de todo lo pendiente
+    bool sincronizar();
+
+    // Sincroniza lo pendiente y reemplaza el archivo por uno vacío (compactación
+    // del log); quien tenga mapeado el anterior lo sigue leyendo entero
+    bool truncar();
+
+    void cambiar_modo(ModoDurabilidad nuevo_modo);
+    ModoDurabilidad obtener_modo() const;
+    void cambiar_intervalo_asincrono(std::chrono::milliseconds intervalo);
+
+    EstadisticasCommit estadisticas(ModoDurabilidad modo_consultado) const;
+    void reiniciar_estadisticas();
+
+private:
+    struct Contadores {
+        uint64_t commits = 0;
+        uint64_t lotes = 0;
+        uint64_t fsyncs = 0;
+        uint64_t bytes = 0;
+        double latencia_total_us = 0.0;
+        double latencia_max_us = 0.0;
+        std::chrono::steady_clock::time_point primer_commit;
+        std::chrono::steady_clock::time_point ultimo_commit;
+    };
+
+    std::string ruta;
+    int fd;
+    ModoDurabilidad modo;
+    std::chrono::milliseconds intervalo_asincrono{50};
+
+    mutable std::mutex mtx;
+    std::condition_variable cv_escritor;   // Despierta al hilo escritor
+    std::condition_variable cv_durable;    // Despierta a los committers en espera
+    std::string pendiente;                 // Lote en formación (modo GRUPO)
+    uint64_t ultima_secuencia = 0;         // Último ticket entregado
+    uint64_t secuencia_escrita = 0;        // Tickets ya escritos en el archivo
+    uint64_t secuencia_durable = 0;        // Tickets ya sincronizados con fsync
+    bool error = false;
+    bool detener = false;
+    bool sincronizando = false;   // El hilo escritor hace fsync sin el lock
+    std::array<Contadores, 4> contadores;
+    std::thread hilo;
+
+    void ejecutar_escritor();
+    bool escribir_pendientes_sin_lock();
+    Contadores& contadores_de(ModoDurabilidad m);
+};
+
+#endif // ESCRITOR_LOG_HPP
@@ -0,0 +1,49 @@
+#ifndef FILTRO_BLOOM_HPP
+#define FILTRO_BLOOM_HPP
+
+#include <string_view>
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+// Filtro de Bloom por bloques para descartar claves que no existen sin tocar
+// el índice: cada clave marca BITS_POR_CLAVE bits dentro de un solo bloque de
+// 64 bytes, así que una consulta lee una línea de caché. "No" es definitivo;
+// "quizás" se confirma en el índice.
+//
+// Solo se agregan claves y los bits se escriben con operaciones atómicas:
+// un escritor puede agregar mientras otros hilos consultan sin bloquear.
+// Una clave agregada se ve en las consultas que sincronizan con el escritor
+// después del agregado (por ejemplo, a través de la versión publicada de la
+// tabla de usuarios).
+class FiltroBloom {
+public:
+    // Dimensionado para 'capacidad' claves con ~0,5% de falsos positivos
+    explicit FiltroBloom(size_t capacidad);
+
+    FiltroBloom(const FiltroBloom&) = delete;
+    FiltroBloom& operator=(const FiltroBloom&) = delete;
+
+    void agregar(std::string_view clave);
+    bool puede_contener(std::string_view clave) const;
+
+    size_t size() const { return claves.load(std::memory_order_relaxed); }
+    size_t capacidad() const { return capacidad_maxima; }
+    // Pasada la capacidad los falsos positivos crecen: hay que rehacerlo más grande
+    bool lleno() const { return size() >= capacidad_maxima; }
+
+private:
+    static constexpr size_t PALABRAS_POR_BLOQUE = 8;   // 512 bits
+    static constexpr int BITS_POR_CLAVE = 6;
+
+    size_t capacidad_maxima;
+    size_t bloques;
+    std::unique_ptr<std::atomic<uint64_t>[]> palabras;
+    std::atomic<size_t> claves{0};
+
+    static uint64_t hash(std::string_view clave);
+    size_t bloque_de(uint64_t h) const;
+};
+
+#endif // FILTRO_BLOOM_HPP
@@ -0,0 +1,36 @@
+#ifndef IO_ARCHIVOS_HPP
+#define IO_ARCHIVOS_HPP
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+// Acceso a archivos por descriptor con fsync explícito (POSIX y Windows).
+// Lo usan el escritor de logs y las escrituras de archivos completos.
+namespace io_archivos {
+
+int abrir_para_append(const std::string& ruta);
+bool escribir_todo(int fd, const char* datos, size_t longitud);
+bool sincronizar_fd(int fd);
+void cerrar_fd(int fd);
+
+// Reemplaza el contenido de 'ruta' sin dejarlo nunca a medias: escribe un
+// temporal, lo sincroniza, lo renombra sobre el original y sincroniza el
+// directorio para que el rename también sea durable
+bool reemplazar_archivo(const std::string& ruta, std::string_view contenido);
+
+// Para contenidos que se escriben de a poco: el llamador escribe completo
+// ruta_temporal(ruta) y confirmar_reemplazo() hace el resto del camino de
+// reemplazar_archivo (fsync, rename, fsync del directorio). Si falla, el
+// temporal se borra y 'ruta' queda como estaba.
+constexpr const char* SUFIJO_TEMPORAL = ".tmp";
+std::string ruta_temporal(const std::string& ruta);
+bool confirmar_reemplazo(const std::string& ruta);
+
+// CRC-32 (polinomio IEEE 802.3) para validar registros y segmentos
+uint32_t calcular_crc32(const char* datos, size_t longitud);
+
+} // namespace io_archivos
+
+#endif // IO_ARCHIVOS_HPP
@@ -0,0 +1,30 @@
+#ifndef MARCAS_TIEMPO_HPP
+#define MARCAS_TIEMPO_HPP
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+// Conversión entre las fechas de las transacciones ("AAAA-MM-DD hh:mm:ss",
+// hora local) y segundos enteros desde 1970-01-01 00:00:00. La fecha se
+// toma tal cual, sin zona horaria: dos fechas quedan en el mismo orden y a
+// la misma distancia que sus textos. Lo usan los segmentos archivados y el
+// índice temporal del historial.
+namespace marcas_tiempo {
+
+constexpr size_t LARGO_FECHA = 19;
+// Marca de un registro cuya fecha no tiene el formato canónico
+constexpr int64_t SIN_FECHA = INT64_MIN;
+
+// false si 'fecha' no tiene exactamente el formato o no vuelve a escribirse
+// igual (mes 13, 31 de abril...)
+bool a_segundos(std::string_view fecha, int64_t& segundos);
+
+// Escribe la fecha en LARGO_FECHA bytes, sin terminador
+void formatear(int64_t segundos, char* destino);
+std::string formatear(int64_t segundos);
+
+} // namespace marcas_tiempo
+
+#endif // MARCAS_TIEMPO_HPP
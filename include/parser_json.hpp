@@ -0,0 +1,94 @@
+#ifndef PARSER_JSON_HPP
+#define PARSER_JSON_HPP
+
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <cstdint>
+
+// Valor escalar leído de un objeto JSON. 'texto' apunta al buffer original;
+// en las cadenas es el contenido entre comillas, todavía con los escapes.
+struct ValorJSON {
+    enum class Tipo { CADENA, NUMERO, BOOLEANO, NULO, COMPUESTO };
+    
+    Tipo tipo = Tipo::NULO;
+    std::string_view texto;
+    bool con_escapes = false;
+    
+    bool como_cadena(std::string& destino) const;
+    bool como_double(double& destino) const;
+    bool como_entero(int& destino) const;
+    bool como_entero(uint64_t& destino) const;
+    bool como_bool(bool& destino) const;
+};
+
+// Tokenizador de una sola pasada sobre un buffer completo. No copia nada:
+// claves y valores son vistas al buffer, que debe seguir vivo mientras se
+// usan. Acepta cualquier espaciado (también JSON minificado); los objetos y
+// arreglos anidados dentro de un registro se devuelven como COMPUESTO.
+class LectorJSON {
+public:
+    explicit LectorJSON(std::string_view texto) : texto(texto) {}
+    
+    // Recorre un objeto plano llamando a campo(clave, valor) por cada miembro.
+    // Si campo devuelve bool, false corta el recorrido y el resultado es false.
+    template <typename Campo>
+    bool recorrer_objeto(Campo&& campo);
+    
+    // Recorre un arreglo de objetos planos; fin_objeto() se llama al cerrar cada uno
+    template <typename Campo, typename FinObjeto>
+    bool recorrer_arreglo(Campo&& campo, FinObjeto&& fin_objeto);
+    
+    // true si desde la posición actual solo queda espacio en blanco
+    bool al_final();
+    
+    size_t posicion() const { return pos; }
+    
+private:
+    std::string_view texto;
+    size_t pos = 0;
+    
+    void saltar_espacios();
+    bool consumir(char c);
+    bool leer_cadena(std::string_view& contenido, bool& con_escapes);
+    bool leer_valor(ValorJSON& valor);
+    bool saltar_compuesto();
+};
+
+template <typename Campo>
+bool LectorJSON::recorrer_objeto(Campo&& campo) {
+    if (!consumir('{')) return false;
+    if (consumir('}')) return true;
+    
+    std::string_view clave;
+    bool clave_con_escapes = false;
+    ValorJSON valor;
+    do {
+        saltar_espacios();
+        if (!leer_cadena(clave, clave_con_escapes) || !consumir(':') || !leer_valor(valor)) {
+            return false;
+        }
+        if constexpr (std::is_same_v<decltype(campo(clave, valor)), bool>) {
+            if (!campo(clave, valor)) return false;
+        } else {
+            campo(clave, valor);
+        }
+    } while (consumir(','));
+    
+    return consumir('}');
+}
+
+template <typename Campo, typename FinObjeto>
+bool LectorJSON::recorrer_arreglo(Campo&& campo, FinObjeto&& fin_objeto) {
+    if (!consumir('[')) return false;
+    if (consumir(']')) return true;
+    
+    do {
+        if (!recorrer_objeto(campo)) return false;
+        fin_objeto();
+    } while (consumir(','));
+    
+    return consumir(']');
+}
+
+#endif // PARSER_JSON_HPP
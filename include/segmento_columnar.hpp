@@ -0,0 +1,160 @@
+#ifndef SEGMENTO_COLUMNAR_HPP
+#define SEGMENTO_COLUMNAR_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <functional>
+#include <cstdint>
+#include "database_json.hpp"
+#include "archivo_mapeado.hpp"
+
+// Columnas decodificadas de un bloque de segmento. Las vistas que salen de
+// un segmento apuntan a su diccionario y a estos bloques.
+struct BloqueDecodificado {
+    size_t primera_fila = 0;
+    size_t filas = 0;
+    std::vector<int> ids;
+    std::vector<double> montos;
+    std::vector<uint32_t> origenes;
+    std::vector<uint32_t> destinos;
+    std::vector<uint32_t> tipos;
+    std::vector<int64_t> segundos;           // Fecha de cada fila (SIN_FECHA si no es canónica)
+    std::string fechas;                      // Fechas canónicas, 19 bytes cada una
+    std::vector<uint32_t> indices_fecha;     // Fechas guardadas en el diccionario
+    std::string sospechosas;                 // Mapa de bits
+
+    bool contiene(size_t fila) const { return fila >= primera_fila && fila - primera_fila < filas; }
+};
+
+// Segmento de archivo del historial: un tramo antiguo del log de
+// transacciones, ya cubierto por un checkpoint, guardado por columnas.
+//   - id, monto (centavos) y fecha (segundos): deltas en varint zigzag
+//   - usuarios, tipo y fechas no canónicas: índices a un diccionario
+//   - es_sospechosa: mapa de bits
+// Los registros van en bloques de FILAS_POR_BLOQUE filas que se decodifican
+// por separado; cada bloque y el diccionario pasan además por un compresor
+// LZ propio. El índice de bloques guarda el rango de ids y de fechas de cada
+// uno, así que leer un rango de ids, un período o la cola del segmento solo
+// descomprime los bloques que lo contienen.
+// Se escribe una sola vez y se lee mapeado. Solo el diccionario queda en
+// memoria mientras viva el segmento: los bloques decodificados van a una
+// caché de BLOQUES_EN_CACHE bloques común a todos los segmentos, y un
+// recorrido que toca más bloques que esos los decodifica sin guardarlos.
+class SegmentoColumnar {
+public:
+    static constexpr size_t FILAS_POR_BLOQUE = 4096;
+    static constexpr size_t BLOQUES_EN_CACHE = 32;
+
+    explicit SegmentoColumnar(const std::string& ruta);
+
+    SegmentoColumnar(const SegmentoColumnar&) = delete;
+    SegmentoColumnar& operator=(const SegmentoColumnar&) = delete;
+
+    // Codifica 'registros', que son todos los del prefijo 'prefijo_log' del
+    // log, en el formato de segmento. Con 'comprimir' en false los bloques se
+    // guardan sin la etapa LZ (para comparar).
+    static std::string codificar(const std::vector<TransaccionVista>& registros,
+                                 std::string_view prefijo_log, bool comprimir = true);
+
+    // false si el archivo no existe, no es un segmento o su CRC no coincide
+    bool esta_abierto() const { return valido; }
+    size_t size() const { return registros; }
+    int id_maximo() const { return id_max; }
+    size_t cantidad_bloques() const { return bloques.size(); }
+
+    // true si 'log' todavía empieza con el prefijo que archivó este segmento
+    // (caída entre escribir el segmento y recortar el log)
+    bool cubre_prefijo(std::string_view log) const;
+    uint64_t bytes_prefijo() const { return largo_prefijo; }
+    // CRC de la cabecera, el diccionario y el índice, que lleva el CRC de
+    // cada bloque: dos segmentos con el mismo son el mismo contenido
+    uint32_t crc_cabecera() const { return crc_indice; }
+
+    // Decodifica todos los bloques, sin guardarlos; false si alguno está dañado
+    bool verificar() const;
+
+    // Bloque con 'fila': el de la caché si está y, si no, uno decodificado
+    // solo para quien lo pide (un cursor, que lee cada bloque una vez);
+    // nullptr si está dañado
+    std::shared_ptr<const BloqueDecodificado> bloque_de(size_t fila) const;
+    // 'bloque' debe contener la fila. Las cadenas de la vista apuntan al
+    // diccionario y a 'bloque'.
+    TransaccionVista vista(const BloqueDecodificado& bloque, size_t fila) const;
+
+    // Las funciones siguientes agregan vistas a 'vistas', en orden de fila, y
+    // a 'decodificados' los bloques a los que apuntan: las vistas valen
+    // mientras se conserven el segmento y esos bloques.
+    // Filas [desde, hasta); false si algún bloque está dañado.
+    bool vistas_filas(size_t desde, size_t hasta, std::vector<TransaccionVista>& vistas,
+                      BloquesDecodificados& decodificados) const;
+    // Las últimas 'limite' filas en las que 'nombre' (texto JSON escapado)
+    // es origen o destino. Busca el índice del nombre en el diccionario y
+    // compara números, sin armar las vistas de los demás.
+    void vistas_de_usuario(std::string_view nombre, size_t limite, std::vector<TransaccionVista>& vistas,
+                           BloquesDecodificados& decodificados) const;
+    // Filas con id en [desde, hasta]; decodifica solo los bloques cuyo rango
+    // de ids se cruza con el pedido
+    void vistas_por_id(int desde, int hasta, std::vector<TransaccionVista>& vistas,
+                       BloquesDecodificados& decodificados) const;
+    // Filas con fecha en [desde, hasta], en segundos (marcas_tiempo). Busca
+    // en el índice el primer bloque que puede tenerlas y decodifica solo los
+    // que se cruzan con el período.
+    void vistas_por_fecha(int64_t desde, int64_t hasta, std::vector<TransaccionVista>& vistas,
+                          BloquesDecodificados& decodificados) const;
+    // Llama a visitar(vista) por cada fila que cumple 'consulta', en orden,
+    // hasta que devuelva false (y entonces devuelve false). La vista vale
+    // durante la llamada. Los filtros se evalúan sobre las columnas; los
+    // bloques que por su rango de ids o de fechas no pueden cumplirla no se
+    // decodifican, y si una cadena pedida no está en el diccionario no se
+    // decodifica ninguno.
+    bool recorrer_consulta(const ConsultaTransacciones& consulta,
+                           const std::function<bool(const TransaccionVista&)>& visitar) const;
+
+private:
+    struct Bloque {
+        size_t primera_fila = 0;
+        size_t filas = 0;
+        int id_min = 0;
+        int id_max = 0;
+        int64_t segundos_min = 0;      // Rango de fechas canónicas del bloque
+        int64_t segundos_max = 0;
+        int64_t maximo_acumulado = 0;  // Mayor segundos_max de este bloque y los anteriores
+        std::string_view datos;        // Sobre el mapeo
+        uint32_t crc = 0;
+    };
+
+    ArchivoMapeado archivo;
+    uint64_t numero = 0;              // Distingue a este segmento en la caché de bloques
+    bool valido = false;
+    size_t registros = 0;
+    int id_max = 0;
+    uint64_t largo_prefijo = 0;
+    uint32_t crc_prefijo = 0;
+    uint32_t crc_inicio = 0;          // CRC de los primeros bytes del prefijo
+    uint32_t crc_indice = 0;          // CRC de todo lo anterior a los bloques
+    size_t filas_por_bloque = FILAS_POR_BLOQUE;
+    std::string_view datos_diccionario;
+    std::vector<Bloque> bloques;
+
+    mutable std::once_flag carga_diccionario;
+    mutable bool diccionario_cargado = false;
+    mutable std::string texto_diccionario;   // Diccionario descomprimido
+    mutable std::vector<std::string_view> diccionario;
+    mutable std::vector<bool> con_escapes;   // Entrada del diccionario con '\'
+
+    bool abrir_por_bloques(std::string_view datos);
+    bool cargar_diccionario() const;
+    void decodificar_diccionario() const;
+    // El bloque 'indice' decodificado, de la caché o decodificado de nuevo
+    // (y guardado en ella si 'guardar'); nullptr si está dañado
+    std::shared_ptr<const BloqueDecodificado> obtener_bloque(size_t indice, bool guardar) const;
+    std::shared_ptr<const BloqueDecodificado> decodificar_bloque(const Bloque& bloque) const;
+    // Agrega 'bloque' a 'decodificados' si no es el último que tiene
+    static void fijar(const std::shared_ptr<const BloqueDecodificado>& bloque,
+                      BloquesDecodificados& decodificados);
+};
+
+#endif // SEGMENTO_COLUMNAR_HPP
@@ -0,0 +1,47 @@
+#ifndef SERIALIZADOR_JSON_HPP
+#define SERIALIZADOR_JSON_HPP
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+// Contraparte de LectorJSON para escribir: arma registros y archivos JSON
+// sobre un buffer que se reutiliza. Los números se escriben con
+// std::to_chars, las cadenas se escapan directamente en el buffer y el marco
+// de los registros del log (longitud y CRC32) se completa en el lugar, sin
+// copiar el JSON. Una vez que el buffer alcanzó el tamaño de lo que se
+// escribe, no vuelve a reservar memoria; varios registros seguidos salen con
+// un solo write.
+class SerializadorJSON {
+public:
+    void limpiar() { buffer.clear(); }
+    std::string_view texto() const { return buffer; }
+    size_t size() const { return buffer.size(); }
+    bool empty() const { return buffer.empty(); }
+    
+    // Registro del log: "<longitud hex> <crc32 hex> <json>\n". Lo que se
+    // escriba entre abrir_registro() y cerrar_registro() es el JSON.
+    void abrir_registro();
+    void cerrar_registro();
+    
+    void literal(std::string_view texto) { buffer.append(texto.data(), texto.size()); }
+    // Entre comillas, escapada
+    void cadena(std::string_view texto);
+    // Entre comillas, tal cual: para cadenas que ya vienen escapadas del log
+    void cadena_escapada(std::string_view texto);
+    void entero(int64_t valor);
+    void natural(uint64_t valor);
+    // Dos decimales fijos, igual que std::fixed con std::setprecision(2)
+    void monto(double valor);
+    void booleano(bool valor) { literal(valor ? "true" : "false"); }
+    
+    // Agrega 'texto' escapado al final de 'destino'
+    static void escapar(std::string_view texto, std::string& destino);
+    
+private:
+    std::string buffer;
+    size_t inicio_registro = 0;
+};
+
+#endif // SERIALIZADOR_JSON_HPP
@@ -21,7 +21,16 @@ SOURCES += \
     src/productor_consumidor.cpp \
     src/lectores_escritores.cpp \
     src/monitor.cpp \
-    src/deadlock.cpp
+    src/deadlock.cpp \
+    src/escritor_log.cpp \
+    src/io_archivos.cpp \
+    src/parser_json.cpp \
+    src/archivo_mapeado.cpp \
+    src/segmento_columnar.cpp \
+    src/database_fragmentada.cpp \
+    src/marcas_tiempo.cpp \
+    src/serializador_json.cpp \
+    src/filtro_bloom.cpp
 
 # Archivos de cabecera
 HEADERS += \
@@ -32,7 +41,16 @@ HEADERS += \
     include/lectores_escritores.hpp \
     include/monitor.hpp \
     include/deadlock.hpp \
-    include/semaforo.hpp
+    include/semaforo.hpp \
+    include/escritor_log.hpp \
+    include/io_archivos.hpp \
+    include/parser_json.hpp \
+    include/archivo_mapeado.hpp \
+    include/segmento_columnar.hpp \
+    include/database_fragmentada.hpp \
+    include/marcas_tiempo.hpp \
+    include/serializador_json.hpp \
+    include/filtro_bloom.hpp
 
 # Flags del compilador
 QMAKE_CXXFLAGS += -pthread
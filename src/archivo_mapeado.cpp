@@ -0,0 +1,90 @@
+#include "archivo_mapeado.hpp"
+#include <algorithm>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+ArchivoMapeado::ArchivoMapeado(const std::string& ruta) {
+    HANDLE archivo = CreateFileA(ruta.c_str(), GENERIC_READ,
+                                 FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                 nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (archivo == INVALID_HANDLE_VALUE) return;
+    
+    LARGE_INTEGER largo;
+    if (GetFileSizeEx(archivo, &largo)) {
+        tamanio = static_cast<size_t>(largo.QuadPart);
+        abierto = true;
+        if (tamanio > 0) {
+            mapeo = CreateFileMappingA(archivo, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            void* vista = mapeo ? MapViewOfFile(mapeo, FILE_MAP_READ, 0, 0, tamanio) : nullptr;
+            if (vista) {
+                datos = static_cast<const char*>(vista);
+            } else {
+                tamanio = 0;
+                abierto = false;
+            }
+        }
+    }
+    // La proyección mantiene el archivo abierto por su cuenta
+    CloseHandle(archivo);
+}
+
+ArchivoMapeado::~ArchivoMapeado() {
+    if (datos) UnmapViewOfFile(datos);
+    if (mapeo) CloseHandle(mapeo);
+}
+
+void ArchivoMapeado::descartar_hasta(size_t) const {
+    // Windows recorta el conjunto de trabajo por su cuenta
+}
+
+#else
+
+ArchivoMapeado::ArchivoMapeado(const std::string& ruta) {
+    int fd = ::open(ruta.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    
+    struct stat info;
+    if (::fstat(fd, &info) == 0) {
+        tamanio = static_cast<size_t>(info.st_size);
+        abierto = true;
+        if (tamanio > 0) {
+            void* vista = ::mmap(nullptr, tamanio, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (vista != MAP_FAILED) {
+                datos = static_cast<const char*>(vista);
+                // Las lecturas analíticas recorren el log de principio a fin
+                ::posix_madvise(vista, tamanio, POSIX_MADV_SEQUENTIAL);
+            } else {
+                tamanio = 0;
+                abierto = false;
+            }
+        }
+    }
+    // El mapeo sigue siendo válido después de cerrar el descriptor
+    ::close(fd);
+}
+
+ArchivoMapeado::~ArchivoMapeado() {
+    if (datos) ::munmap(const_cast<char*>(datos), tamanio);
+}
+
+void ArchivoMapeado::descartar_hasta(size_t hasta) const {
+    static const size_t pagina = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    hasta = std::min(hasta, tamanio) / pagina * pagina;
+    if (!datos || hasta == 0) return;
+    // Mapeo privado de solo lectura: descartar es seguro, no hay nada que escribir
+    ::madvise(const_cast<char*>(datos), hasta, MADV_DONTNEED);
+}
+
+#endif
@@ -0,0 +1,504 @@
+#include "database_fragmentada.hpp"
+#include "io_archivos.hpp"
+#include "parser_json.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+
+namespace {
+
+// Líneas del archivo de intenciones, un objeto JSON por línea:
+//   {"op":"transferencia"|"copia", "id", "usuario_origen", ...}  antes de escribir
+//   {"op":"reversion","id":<transferencia>,"reversion":<id de la devolución>}
+//   {"op":"fin","id":<id>}                                        al terminar
+std::string linea_intencion(std::string_view op, const TransaccionDB& t) {
+    SerializadorJSON json;
+    json.literal("{\"op\":");
+    json.cadena(op);
+    json.literal(",\"id\":");
+    json.entero(t.id);
+    json.literal(",\"usuario_origen\":");
+    json.cadena(t.usuario_origen);
+    json.literal(",\"usuario_destino\":");
+    json.cadena(t.usuario_destino);
+    json.literal(",\"monto\":");
+    json.monto(t.monto);
+    json.literal(",\"tipo\":");
+    json.cadena(t.tipo);
+    json.literal(",\"es_sospechosa\":");
+    json.booleano(t.es_sospechosa);
+    json.literal(",\"fecha\":");
+    json.cadena(t.fecha);
+    json.literal("}\n");
+    return std::string(json.texto());
+}
+
+std::string linea_reversion(int id, int reversion) {
+    return "{\"op\":\"reversion\",\"id\":" + std::to_string(id) +
+           ",\"reversion\":" + std::to_string(reversion) + "}\n";
+}
+
+std::string linea_fin(int id) {
+    return "{\"op\":\"fin\",\"id\":" + std::to_string(id) + "}\n";
+}
+
+// Una línea cortada por una caída no se parsea: su escritura no llegó a
+// empezar, porque cada intención es durable antes de tocar los fragmentos
+bool leer_intencion(const std::string& linea, std::string& op, TransaccionDB& t, int& reversion) {
+    op.clear();
+    t = TransaccionDB{0, "", "", 0.0, "", false, ""};
+    reversion = 0;
+    LectorJSON lector(linea);
+    bool valido = true;
+    bool leido = lector.recorrer_objeto([&](std::string_view clave, const ValorJSON& valor) {
+        if (clave == "op") valido &= valor.como_cadena(op);
+        else if (clave == "id") valido &= valor.como_entero(t.id);
+        else if (clave == "reversion") valido &= valor.como_entero(reversion);
+        else if (clave == "usuario_origen") valido &= valor.como_cadena(t.usuario_origen);
+        else if (clave == "usuario_destino") valido &= valor.como_cadena(t.usuario_destino);
+        else if (clave == "monto") valido &= valor.como_double(t.monto);
+        else if (clave == "tipo") valido &= valor.como_cadena(t.tipo);
+        else if (clave == "es_sospechosa") valido &= valor.como_bool(t.es_sospechosa);
+        else if (clave == "fecha") valido &= valor.como_cadena(t.fecha);
+    });
+    return leido && valido && lector.al_final() && !op.empty() && t.id > 0;
+}
+
+// Registro que devuelve al origen el débito de 'transferencia'
+TransaccionDB devolucion_de(const TransaccionDB& transferencia, int id) {
+    return TransaccionDB{id, transferencia.usuario_destino, transferencia.usuario_origen,
+                         transferencia.monto, "REVERSION", false, transferencia.fecha};
+}
+
+} // namespace
+
+DatabaseFragmentada::DatabaseFragmentada(size_t cantidad, const std::string& archivo_usuarios,
+                                         const std::string& archivo_transacciones)
+    : archivo_intenciones(archivo_transacciones + ".pend") {
+    cantidad = std::max<size_t>(1, cantidad);
+    fragmentos.reserve(cantidad);
+    for (size_t i = 0; i < cantidad; ++i) {
+        auto fragmento = std::make_unique<Fragmento>();
+        fragmento->db = std::make_unique<DatabaseJSON>(ruta_fragmento(archivo_usuarios, i),
+                                                       ruta_fragmento(archivo_transacciones, i));
+        for (const auto& u : fragmento->db->cargar_usuarios()) {
+            fragmento_por_nombre.emplace(u.nombre, i);
+            fragmento_por_cuenta.emplace(u.cuenta_id, i);
+        }
+        fragmentos.push_back(std::move(fragmento));
+    }
+
+    resolver_intenciones();
+
+    // Los ids los reparte el fragmento 0 (con su techo persistido); arranca
+    // por encima de lo que ya usó cualquier otro fragmento
+    int maximo = 0;
+    for (size_t i = 1; i < fragmentos.size(); ++i) {
+        maximo = std::max(maximo, fragmentos[i]->db->consultar_siguiente_id());
+    }
+    int propio = fragmentos[0]->db->consultar_siguiente_id();
+    if (propio < maximo && fragmentos[0]->db->reservar_ids(maximo - propio) < 1) {
+        std::cerr << "[DB] No se pudo avanzar la secuencia de ids de los fragmentos" << std::endl;
+    }
+}
+
+std::string DatabaseFragmentada::ruta_fragmento(const std::string& ruta, size_t indice) {
+    // "datos/usuarios.json" -> "datos/usuarios_3.json"
+    std::filesystem::path original(ruta);
+    std::string nombre = original.stem().string() + "_" + std::to_string(indice) +
+                         original.extension().string();
+    return (original.parent_path() / nombre).string();
+}
+
+size_t DatabaseFragmentada::fragmento_de_cuenta(const std::string& cuenta_id) const {
+    // FNV-1a: el reparto no puede depender de la implementación de std::hash,
+    // porque decide en qué archivos queda cada usuario
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : cuenta_id) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    // Los bits bajos de FNV siguen al último carácter (cuentas correlativas
+    // alternarían de fragmento): mezcla final de MurmurHash3
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ull;
+    hash ^= hash >> 33;
+    return static_cast<size_t>(hash % fragmentos.size());
+}
+
+bool DatabaseFragmentada::buscar_fragmento(const std::string& nombre, size_t& indice) const {
+    std::shared_lock<std::shared_mutex> lock(mtx_directorio);
+    auto it = fragmento_por_nombre.find(nombre);
+    if (it == fragmento_por_nombre.end()) return false;
+    indice = it->second;
+    return true;
+}
+
+bool DatabaseFragmentada::contiene_transaccion(size_t indice, const std::string& nombre, int id) {
+    // Lo buscado suele estar entre lo último del usuario: se amplía la
+    // ventana solo si no aparece
+    for (int limite : {64, 4096, 0}) {
+        auto historial = fragmentos[indice]->db->cargar_transacciones_usuario(nombre, limite);
+        for (auto it = historial.rbegin(); it != historial.rend(); ++it) {
+            if (it->id == id) return true;
+        }
+        if (limite == 0 || historial.size() < static_cast<size_t>(limite)) return false;
+    }
+    return false;
+}
+
+bool DatabaseFragmentada::registrar_intencion(const std::string& linea, bool esperar) {
+    EscritorLog::Ticket ticket;
+    {
+        std::lock_guard<std::mutex> lock(mtx_intenciones);
+        if (!intenciones || !intenciones->agregar(linea, ticket)) return false;
+    }
+    return !esperar || intenciones->esperar_durable(ticket);
+}
+
+bool DatabaseFragmentada::abrir_intencion(const std::string& linea) {
+    EscritorLog::Ticket ticket;
+    {
+        std::lock_guard<std::mutex> lock(mtx_intenciones);
+        if (!intenciones || !intenciones->agregar(linea, ticket)) return false;
+        intenciones_en_curso++;
+    }
+    if (intenciones->esperar_durable(ticket)) return true;
+    std::lock_guard<std::mutex> lock(mtx_intenciones);
+    intenciones_en_curso--;
+    intenciones_abiertas++;
+    return false;
+}
+
+void DatabaseFragmentada::cerrar_intencion(int id, bool terminada) {
+    std::lock_guard<std::mutex> lock(mtx_intenciones);
+    EscritorLog::Ticket ticket;
+    if (!terminada || !intenciones->agregar(linea_fin(id), ticket)) intenciones_abiertas++;
+    intenciones_en_curso--;
+}
+
+void DatabaseFragmentada::resolver_intenciones() {
+    // Intenciones sin "fin", por id. Cada una se resuelve según lo que llegó
+    // a cada fragmento: en los modos sin fsync por commit el crédito puede
+    // estar en disco sin el débito, o al revés.
+    std::map<int, Intencion> pendientes;
+    {
+        std::ifstream archivo(archivo_intenciones);
+        std::string linea;
+        std::string op;
+        TransaccionDB t{};
+        int reversion = 0;
+        while (std::getline(archivo, linea)) {
+            if (!leer_intencion(linea, op, t, reversion)) continue;
+            if (op == "transferencia" || op == "copia") {
+                pendientes[t.id] = Intencion{op == "transferencia", t, 0};
+            } else if (op == "reversion") {
+                auto it = pendientes.find(t.id);
+                if (it != pendientes.end()) it->second.reversion = reversion;
+            } else if (op == "fin") {
+                pendientes.erase(t.id);
+            }
+        }
+    }
+
+    size_t sin_resolver = 0;
+    for (const auto& [id, intencion] : pendientes) {
+        const TransaccionDB& t = intencion.transaccion;
+        size_t origen = 0;
+        size_t destino = 0;
+        if (!buscar_fragmento(t.usuario_origen, origen) ||
+            !buscar_fragmento(t.usuario_destino, destino) || origen == destino) {
+            continue;
+        }
+        bool en_origen = contiene_transaccion(origen, t.usuario_origen, id);
+        bool en_destino = contiene_transaccion(destino, t.usuario_destino, id);
+        if (en_origen == en_destino) continue;   // Completa o sin empezar
+
+        bool ok = true;
+        if (!intencion.transferencia) {
+            ok = fragmentos[en_origen ? destino : origen]->db->guardar_transaccion(t);
+            std::cout << "[DB] Transacción " << id << " entre fragmentos completada" << std::endl;
+        } else if (intencion.reversion != 0) {
+            // Anulada: si el débito quedó sin devolver, se devuelve
+            if (en_origen && !contiene_transaccion(origen, t.usuario_origen, intencion.reversion)) {
+                ok = fragmentos[origen]->db->commit_movimiento(t.usuario_origen, t.monto,
+                                                               devolucion_de(t, intencion.reversion));
+                std::cout << "[DB] Transferencia " << id << " entre fragmentos revertida" << std::endl;
+            }
+        } else if (en_origen) {
+            ok = fragmentos[destino]->db->commit_movimiento(t.usuario_destino, t.monto, t);
+            std::cout << "[DB] Crédito de la transferencia " << id << " completado" << std::endl;
+        } else {
+            // El crédito ya es durable: el débito se aplica aunque el saldo
+            // actual del origen no alcance
+            ok = fragmentos[origen]->db->completar_movimiento(t.usuario_origen, -t.monto, t);
+            std::cout << "[DB] Débito de la transferencia " << id << " completado" << std::endl;
+        }
+        if (!ok) {
+            sin_resolver++;
+            std::cerr << "[DB] No se pudo completar la transacción " << id << " entre fragmentos" << std::endl;
+        }
+    }
+
+    // Con todo resuelto y sincronizado, el archivo de intenciones empieza vacío
+    if (sin_resolver == 0 && sincronizar_log() && !pendientes.empty()) {
+        io_archivos::reemplazar_archivo(archivo_intenciones, "");
+    }
+    intenciones_abiertas = sin_resolver;
+    // Las intenciones siempre se sincronizan (group commit), con cualquier
+    // durabilidad de los fragmentos
+    intenciones = std::make_unique<EscritorLog>(archivo_intenciones, ModoDurabilidad::GRUPO);
+    if (!intenciones->esta_abierto()) {
+        std::cerr << "[DB] No se pudo abrir " << archivo_intenciones << std::endl;
+    }
+}
+
+bool DatabaseFragmentada::guardar_usuario(const UsuarioDB& usuario) {
+    // Las altas se serializan entre sí (el nombre es único en todos los
+    // fragmentos); los lectores del directorio solo esperan la inserción
+    std::unique_lock<std::mutex> lock_altas(mtx_altas);
+    if (usuario_existe(usuario.nombre)) return false;
+
+    size_t indice = fragmento_de_cuenta(usuario.cuenta_id);
+    DatabaseJSON::CommitPendiente pendiente;
+    {
+        std::lock_guard<std::mutex> lock(fragmentos[indice]->mtx);
+        if (!fragmentos[indice]->db->guardar_usuario(usuario, &pendiente)) return false;
+    }
+    {
+        std::unique_lock<std::shared_mutex> lock_directorio(mtx_directorio);
+        fragmento_por_nombre.emplace(usuario.nombre, indice);
+        fragmento_por_cuenta.emplace(usuario.cuenta_id, indice);
+    }
+    lock_altas.unlock();
+    return fragmentos[indice]->db->esperar_commit(pendiente);
+}
+
+bool DatabaseFragmentada::actualizar_saldo(const std::string& nombre, double nuevo_saldo) {
+    size_t indice = 0;
+    if (!buscar_fragmento(nombre, indice)) return false;
+    DatabaseJSON::CommitPendiente pendiente;
+    {
+        std::lock_guard<std::mutex> lock(fragmentos[indice]->mtx);
+        if (!fragmentos[indice]->db->actualizar_saldo(nombre, nuevo_saldo, &pendiente)) return false;
+    }
+    return fragmentos[indice]->db->esperar_commit(pendiente);
+}
+
+std::vector<UsuarioDB> DatabaseFragmentada::cargar_usuarios() {
+    std::vector<UsuarioDB> usuarios;
+    for (const auto& fragmento : fragmentos) {
+        auto propios = fragmento->db->cargar_usuarios();
+        usuarios.insert(usuarios.end(), propios.begin(), propios.end());
+    }
+    return usuarios;
+}
+
+UsuarioDB DatabaseFragmentada::obtener_usuario(const std::string& nombre) {
+    size_t indice = 0;
+    if (!buscar_fragmento(nombre, indice)) return UsuarioDB{"", "", -1.0, ""};
+    return fragmentos[indice]->db->obtener_usuario(nombre);
+}
+
+UsuarioDB DatabaseFragmentada::obtener_usuario_por_cuenta(const std::string& cuenta_id) {
+    size_t indice = 0;
+    {
+        std::shared_lock<std::shared_mutex> lock(mtx_directorio);
+        auto it = fragmento_por_cuenta.find(cuenta_id);
+        if (it == fragmento_por_cuenta.end()) return UsuarioDB{"", "", -1.0, ""};
+        indice = it->second;
+    }
+    return fragmentos[indice]->db->obtener_usuario_por_cuenta(cuenta_id);
+}
+
+bool DatabaseFragmentada::usuario_existe(const std::string& nombre) {
+    size_t indice = 0;
+    return buscar_fragmento(nombre, indice);
+}
+
+int DatabaseFragmentada::obtener_siguiente_id_transaccion() {
+    return fragmentos[0]->db->obtener_siguiente_id_transaccion();
+}
+
+bool DatabaseFragmentada::guardar_transaccion(const TransaccionDB& transaccion) {
+    // Usuarios desconocidos: el fragmento sale del hash del nombre
+    size_t origen = 0;
+    size_t destino = 0;
+    if (!buscar_fragmento(transaccion.usuario_origen, origen)) {
+        origen = fragmento_de_cuenta(transaccion.usuario_origen);
+    }
+    if (!buscar_fragmento(transaccion.usuario_destino, destino)) destino = origen;
+
+    DatabaseJSON& db_origen = *fragmentos[origen]->db;
+    if (origen == destino) {
+        DatabaseJSON::CommitPendiente pendiente;
+        {
+            std::lock_guard<std::mutex> lock(fragmentos[origen]->mtx);
+            if (!db_origen.guardar_transaccion(transaccion, &pendiente)) return false;
+        }
+        return db_origen.esperar_commit(pendiente);
+    }
+
+    DatabaseJSON& db_destino = *fragmentos[destino]->db;
+    if (!abrir_intencion(linea_intencion("copia", transaccion))) return false;
+    DatabaseJSON::CommitPendiente en_destino;
+    DatabaseJSON::CommitPendiente en_origen;
+    bool copiada_destino = false;
+    bool copiada_origen = false;
+    {
+        std::lock_guard<std::mutex> lock_primero(fragmentos[std::min(origen, destino)]->mtx);
+        std::lock_guard<std::mutex> lock_segundo(fragmentos[std::max(origen, destino)]->mtx);
+        copiada_destino = db_destino.guardar_transaccion(transaccion, &en_destino);
+        copiada_origen = copiada_destino && db_origen.guardar_transaccion(transaccion, &en_origen);
+    }
+    // Sin ninguna copia escrita la intención se cierra sin nada que completar
+    bool durable = copiada_origen && db_destino.esperar_commit(en_destino) &&
+                   db_origen.esperar_commit(en_origen);
+    cerrar_intencion(transaccion.id, durable || !copiada_destino);
+    return durable;
+}
+
+bool DatabaseFragmentada::commit_transferencia(const std::string& origen, const std::string& destino,
+                                               double monto, const TransaccionDB& transaccion) {
+    size_t indice_origen = 0;
+    size_t indice_destino = 0;
+    if (!buscar_fragmento(origen, indice_origen) || !buscar_fragmento(destino, indice_destino)) {
+        return false;
+    }
+
+    DatabaseJSON& db_origen = *fragmentos[indice_origen]->db;
+    if (indice_origen == indice_destino) {
+        DatabaseJSON::CommitPendiente pendiente;
+        {
+            std::lock_guard<std::mutex> lock(fragmentos[indice_origen]->mtx);
+            if (!db_origen.commit_transferencia(origen, destino, monto, transaccion, &pendiente)) return false;
+        }
+        return db_origen.esperar_commit(pendiente);
+    }
+
+    TransaccionDB registro = transaccion;
+    registro.usuario_origen = origen;
+    registro.usuario_destino = destino;
+    registro.monto = monto;
+
+    // Una transferencia que ya se ve sin saldo no deja intención. La
+    // intención se sincroniza sin ningún mutex de fragmento tomado.
+    DatabaseJSON& db_destino = *fragmentos[indice_destino]->db;
+    if (registro.id < 1 || db_origen.obtener_usuario(origen).saldo < monto) return false;
+    if (!abrir_intencion(linea_intencion("transferencia", registro))) return false;
+
+    // Los mutex se toman siempre en orden de índice: dos transferencias
+    // cruzadas entre los mismos fragmentos no pueden bloquearse mutuamente.
+    // commit_movimiento rechaza el débito si el saldo ya no alcanza.
+    DatabaseJSON::CommitPendiente debito;
+    DatabaseJSON::CommitPendiente credito;
+    bool debitada = false;
+    bool acreditada = false;
+    {
+        std::lock_guard<std::mutex> lock_primero(fragmentos[std::min(indice_origen, indice_destino)]->mtx);
+        std::lock_guard<std::mutex> lock_segundo(fragmentos[std::max(indice_origen, indice_destino)]->mtx);
+        debitada = db_origen.commit_movimiento(origen, -monto, registro, &debito);
+        acreditada = debitada && db_destino.commit_movimiento(destino, monto, registro, &credito);
+    }
+    if (!debitada) {
+        cerrar_intencion(registro.id, true);
+        return false;
+    }
+
+    // La durabilidad se espera con los mutex de los fragmentos libres
+    bool debito_durable = db_origen.esperar_commit(debito);
+    if (debito_durable && acreditada && db_destino.esperar_commit(credito)) {
+        cerrar_intencion(registro.id, true);
+        return true;
+    }
+    // El crédito no se escribió: se devuelve el débito. Si el crédito llegó
+    // al log pero no se pudo sincronizar, o el débito no es durable, la
+    // intención queda abierta y la resuelve el arranque con lo que haya en disco.
+    cerrar_intencion(registro.id, debito_durable && !acreditada && devolver_debito(indice_origen, registro));
+    return false;
+}
+
+bool DatabaseFragmentada::devolver_debito(size_t indice_origen, const TransaccionDB& transferencia) {
+    // La devolución lleva su propio id, anotado en la intención antes de
+    // escribirla: el arranque sabe si ya se hizo
+    int id = fragmentos[0]->db->reservar_ids(1);
+    if (id < 1 || !registrar_intencion(linea_reversion(transferencia.id, id), true)) return false;
+    DatabaseJSON& db_origen = *fragmentos[indice_origen]->db;
+    DatabaseJSON::CommitPendiente pendiente;
+    {
+        std::lock_guard<std::mutex> lock(fragmentos[indice_origen]->mtx);
+        if (!db_origen.commit_movimiento(transferencia.usuario_origen, transferencia.monto,
+                                         devolucion_de(transferencia, id), &pendiente)) {
+            return false;
+        }
+    }
+    if (!db_origen.esperar_commit(pendiente)) return false;
+    std::cerr << "[DB] Transferencia " << transferencia.id << " entre fragmentos revertida" << std::endl;
+    return true;
+}
+
+std::vector<TransaccionDB> DatabaseFragmentada::cargar_transacciones(int limite) {
+    std::vector<TransaccionDB> transacciones;
+    for (const auto& fragmento : fragmentos) {
+        auto propias = fragmento->db->cargar_transacciones(limite);
+        transacciones.insert(transacciones.end(), std::make_move_iterator(propias.begin()),
+                             std::make_move_iterator(propias.end()));
+    }
+
+    // Las transacciones entre fragmentos están en los dos: se deja una
+    std::stable_sort(transacciones.begin(), transacciones.end(),
+                     [](const TransaccionDB& a, const TransaccionDB& b) { return a.id < b.id; });
+    transacciones.erase(std::unique(transacciones.begin(), transacciones.end(),
+                                    [](const TransaccionDB& a, const TransaccionDB& b) { return a.id == b.id; }),
+                        transacciones.end());
+    if (limite > 0 && transacciones.size() > static_cast<size_t>(limite)) {
+        transacciones.erase(transacciones.begin(), transacciones.end() - limite);
+    }
+    return transacciones;
+}
+
+std::vector<TransaccionDB> DatabaseFragmentada::cargar_transacciones_usuario(const std::string& nombre,
+                                                                             int limite) {
+    // Cada transacción está también en el fragmento de cada participante
+    size_t indice = 0;
+    if (!buscar_fragmento(nombre, indice)) return {};
+    return fragmentos[indice]->db->cargar_transacciones_usuario(nombre, limite);
+}
+
+bool DatabaseFragmentada::checkpoint() {
+    // Con todos los mutex tomados no hay escrituras entre fragmentos a medias
+    std::vector<std::unique_lock<std::mutex>> locks;
+    for (const auto& fragmento : fragmentos) locks.emplace_back(fragmento->mtx);
+
+    // Lo que cubren las intenciones terminadas debe ser durable antes de borrarlas
+    bool ok = true;
+    for (const auto& fragmento : fragmentos) {
+        ok = fragmento->db->checkpoint() && fragmento->db->sincronizar_log() && ok;
+    }
+    // Una intención en curso puede no haber escrito aún ninguna de sus mitades
+    std::lock_guard<std::mutex> lock(mtx_intenciones);
+    if (ok && intenciones_abiertas == 0 && intenciones_en_curso == 0 && intenciones) {
+        ok = intenciones->truncar();
+    }
+    return ok;
+}
+
+bool DatabaseFragmentada::flush() {
+    bool ok = true;
+    for (const auto& fragmento : fragmentos) ok = fragmento->db->flush() && ok;
+    return ok;
+}
+
+bool DatabaseFragmentada::sincronizar_log() {
+    bool ok = true;
+    for (const auto& fragmento : fragmentos) ok = fragmento->db->sincronizar_log() && ok;
+    return ok;
+}
+
+void DatabaseFragmentada::configurar_durabilidad(ModoDurabilidad modo) {
+    for (const auto& fragmento : fragmentos) fragmento->db->configurar_durabilidad(modo);
+}
@@ -1,12 +1,374 @@
 #include "database_json.hpp"
+#include "io_archivos.hpp"
+#include "parser_json.hpp"
+#include "archivo_mapeado.hpp"
+#include "segmento_columnar.hpp"
+#include "marcas_tiempo.hpp"
 #include <iostream>
 #include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cmath>
+#include <filesystem>
+#include <charconv>
+#include <functional>
+
+namespace {
+
+// Lee 'ruta' completo con una sola lectura
+bool leer_archivo_completo(const std::string& ruta, std::string& destino) {
+    destino.clear();
+    std::ifstream archivo(ruta, std::ios::binary | std::ios::ate);
+    if (!archivo.is_open()) return false;
+    
+    std::streamoff tamanio = archivo.tellg();
+    if (tamanio <= 0) return tamanio == 0;
+    
+    destino.resize(static_cast<size_t>(tamanio));
+    archivo.seekg(0);
+    return static_cast<bool>(archivo.read(&destino[0], static_cast<std::streamsize>(destino.size())));
+}
+
+// Enlace duro de 'origen' en 'destino'; si el sistema de archivos no lo
+// permite (otro dispositivo, FAT), una copia durable que suma a 'copiados'
+bool enlazar_o_copiar(const std::string& origen, const std::string& destino, uint64_t& copiados) {
+    std::error_code ec;
+    std::filesystem::remove(destino, ec);
+    std::filesystem::create_hard_link(origen, destino, ec);
+    if (!ec) return true;
+    
+    ArchivoMapeado archivo(origen);
+    if (!archivo.esta_abierto()) return false;
+    copiados += archivo.contenido().size();
+    return io_archivos::reemplazar_archivo(destino, archivo.contenido());
+}
+
+// Fecha de un registro en segundos, o SIN_FECHA si no es canónica
+int64_t segundos_de(std::string_view fecha) {
+    int64_t segundos = 0;
+    return marcas_tiempo::a_segundos(fecha, segundos) ? segundos : marcas_tiempo::SIN_FECHA;
+}
+
+// Llama a visitar(linea, fin) por cada línea completa del buffer; 'fin' es
+// la posición siguiente al '\n'. Una última línea sin '\n' no se visita.
+template <typename Visitar>
+void recorrer_lineas(std::string_view buffer, Visitar&& visitar) {
+    size_t inicio = 0;
+    while (inicio < buffer.size()) {
+        size_t fin = buffer.find('\n', inicio);
+        if (fin == std::string_view::npos) break;
+        visitar(buffer.substr(inicio, fin - inicio), fin + 1);
+        inicio = fin + 1;
+    }
+}
+
+// Bits de los campos de una transacción; en el log todos son obligatorios
+constexpr unsigned CAMPO_ID           = 1u << 0;
+constexpr unsigned CAMPO_ORIGEN       = 1u << 1;
+constexpr unsigned CAMPO_DESTINO      = 1u << 2;
+constexpr unsigned CAMPO_MONTO        = 1u << 3;
+constexpr unsigned CAMPO_TIPO         = 1u << 4;
+constexpr unsigned CAMPO_SOSPECHOSA   = 1u << 5;
+constexpr unsigned CAMPO_FECHA        = 1u << 6;
+constexpr unsigned CAMPOS_TRANSACCION = (1u << 7) - 1;
+
+// Asigna el campo 'clave' de una transacción; devuelve su bit o 0 si la
+// clave no es de una transacción o el valor no tiene el tipo esperado
+unsigned asignar_campo_transaccion(std::string_view clave, const ValorJSON& valor, TransaccionDB& t) {
+    if (clave == "id") return valor.como_entero(t.id) ? CAMPO_ID : 0u;
+    if (clave == "usuario_origen") return valor.como_cadena(t.usuario_origen) ? CAMPO_ORIGEN : 0u;
+    if (clave == "usuario_destino") return valor.como_cadena(t.usuario_destino) ? CAMPO_DESTINO : 0u;
+    if (clave == "monto") return valor.como_double(t.monto) ? CAMPO_MONTO : 0u;
+    if (clave == "tipo") return valor.como_cadena(t.tipo) ? CAMPO_TIPO : 0u;
+    if (clave == "es_sospechosa") return valor.como_bool(t.es_sospechosa) ? CAMPO_SOSPECHOSA : 0u;
+    if (clave == "fecha") return valor.como_cadena(t.fecha) ? CAMPO_FECHA : 0u;
+    return 0;
+}
+
+// Igual que asignar_campo_transaccion, pero las cadenas quedan como vistas
+// al texto del registro, sin copiarlas
+unsigned asignar_campo_vista(std::string_view clave, const ValorJSON& valor, TransaccionVista& v) {
+    auto cadena = [&](std::string_view& destino, unsigned bit) {
+        if (valor.tipo != ValorJSON::Tipo::CADENA) return 0u;
+        destino = valor.texto;
+        v.con_escapes = v.con_escapes || valor.con_escapes;
+        return bit;
+    };
+    if (clave == "id") return valor.como_entero(v.id) ? CAMPO_ID : 0u;
+    if (clave == "usuario_origen") return cadena(v.usuario_origen, CAMPO_ORIGEN);
+    if (clave == "usuario_destino") return cadena(v.usuario_destino, CAMPO_DESTINO);
+    if (clave == "monto") return valor.como_double(v.monto) ? CAMPO_MONTO : 0u;
+    if (clave == "tipo") return cadena(v.tipo, CAMPO_TIPO);
+    if (clave == "es_sospechosa") return valor.como_bool(v.es_sospechosa) ? CAMPO_SOSPECHOSA : 0u;
+    if (clave == "fecha") return cadena(v.fecha, CAMPO_FECHA);
+    return 0;
+}
+
+bool parsear_vista(std::string_view json, TransaccionVista& vista) {
+    vista = TransaccionVista();
+    unsigned campos = 0;
+    LectorJSON lector(json);
+    bool leido = lector.recorrer_objeto([&](std::string_view clave, const ValorJSON& valor) {
+        campos |= asignar_campo_vista(clave, valor, vista);
+    });
+    return leido && campos == CAMPOS_TRANSACCION;
+}
+
+// Consulta preparada para el log: las cadenas escapadas como en el texto de
+// los registros, que se comparan sin resolver sus escapes
+struct FiltroLog {
+    const ConsultaTransacciones& consulta;
+    std::string usuario;
+    std::string origen;
+    std::string destino;
+    std::string tipo;
+    // Textos que todo registro que cumple contiene tal como lo escribe
+    // serializar_registro: la cadena pedida más selectiva y la marca de
+    // sospechosa. Los registros que no los contienen no se parsean.
+    std::vector<std::string> marcas;
+    std::vector<std::boyer_moore_horspool_searcher<std::string::const_iterator>> buscadores;
+    bool con_periodo;
+    
+    explicit FiltroLog(const ConsultaTransacciones& c)
+        : consulta(c), con_periodo(c.desde != INT64_MIN || c.hasta != INT64_MAX) {
+        SerializadorJSON::escapar(c.usuario, usuario);
+        SerializadorJSON::escapar(c.origen, origen);
+        SerializadorJSON::escapar(c.destino, destino);
+        SerializadorJSON::escapar(c.tipo, tipo);
+        for (const std::string* texto : {&origen, &destino, &usuario, &tipo}) {
+            if (!texto->empty()) {
+                marcas.push_back('"' + *texto + '"');
+                break;
+            }
+        }
+        if (c.es_sospechosa) {
+            marcas.push_back(*c.es_sospechosa ? "\"es_sospechosa\":true" : "\"es_sospechosa\":false");
+        }
+        for (const auto& marca : marcas) buscadores.emplace_back(marca.begin(), marca.end());
+    }
+    
+    bool puede_cumplir(std::string_view linea) const {
+        for (const auto& buscador : buscadores) {
+            if (std::search(linea.begin(), linea.end(), buscador) == linea.end()) return false;
+        }
+        return true;
+    }
+    
+    bool cumple_campo(unsigned campo, const TransaccionVista& v) const {
+        switch (campo) {
+            case CAMPO_ID: return v.id >= consulta.id_desde && v.id <= consulta.id_hasta;
+            case CAMPO_ORIGEN: return origen.empty() || v.usuario_origen == origen;
+            case CAMPO_DESTINO: return destino.empty() || v.usuario_destino == destino;
+            case CAMPO_MONTO: return v.monto >= consulta.monto_minimo && v.monto <= consulta.monto_maximo;
+            case CAMPO_TIPO: return tipo.empty() || v.tipo == tipo;
+            case CAMPO_SOSPECHOSA: return !consulta.es_sospechosa || v.es_sospechosa == *consulta.es_sospechosa;
+            case CAMPO_FECHA: {
+                if (!con_periodo) return true;
+                int64_t segundos = segundos_de(v.fecha);
+                return segundos != marcas_tiempo::SIN_FECHA && segundos >= consulta.desde &&
+                       segundos <= consulta.hasta;
+            }
+        }
+        return true;
+    }
+    
+    // Como parsear_vista, pero deja de leer en el primer campo que no cumple
+    bool parsear(std::string_view json, TransaccionVista& vista) const {
+        vista = TransaccionVista();
+        unsigned campos = 0;
+        LectorJSON lector(json);
+        bool leido = lector.recorrer_objeto([&](std::string_view clave, const ValorJSON& valor) {
+            unsigned campo = asignar_campo_vista(clave, valor, vista);
+            campos |= campo;
+            return campo == 0 || cumple_campo(campo, vista);
+        });
+        return leido && campos == CAMPOS_TRANSACCION &&
+               (usuario.empty() || vista.usuario_origen == usuario || vista.usuario_destino == usuario);
+    }
+};
+
+// Corre tarea(0) ... tarea(partes - 1), cada una en su hilo; la parte 0 la
+// hace el hilo llamador
+template <typename Tarea>
+void ejecutar_en_paralelo(size_t partes, Tarea&& tarea) {
+    std::vector<std::thread> hilos;
+    for (size_t parte = 1; parte < partes; ++parte) {
+        hilos.emplace_back([&tarea, parte] { tarea(parte); });
+    }
+    tarea(0);
+    for (auto& hilo : hilos) hilo.join();
+}
+
+// Partes en que conviene dividir 'trabajo': no más de 'maximo' ni menos de
+// 'minimo_por_parte' unidades por parte (repartir poco cuesta más que hacerlo)
+size_t partes_para(size_t trabajo, size_t minimo_por_parte, size_t maximo) {
+    return std::max<size_t>(1, std::min(maximo, trabajo / minimo_por_parte));
+}
+
+bool asignar_campo_usuario(std::string_view clave, const ValorJSON& valor, UsuarioDB& u) {
+    if (clave == "nombre") return valor.como_cadena(u.nombre);
+    if (clave == "cuenta_id") return valor.como_cadena(u.cuenta_id);
+    if (clave == "saldo") return valor.como_double(u.saldo);
+    if (clave == "fecha_creacion") return valor.como_cadena(u.fecha_creacion);
+    // Una clave desconocida se ignora, como en las transacciones
+    return true;
+}
+
+} // namespace
+
+TransaccionDB TransaccionVista::a_transaccion() const {
+    TransaccionDB t{id, "", "", monto, "", es_sospechosa, ""};
+    if (!con_escapes) {
+        t.usuario_origen.assign(usuario_origen);
+        t.usuario_destino.assign(usuario_destino);
+        t.tipo.assign(tipo);
+        t.fecha.assign(fecha);
+        return t;
+    }
+    
+    auto decodificar = [](std::string_view texto, std::string& destino) {
+        ValorJSON valor;
+        valor.tipo = ValorJSON::Tipo::CADENA;
+        valor.texto = texto;
+        valor.con_escapes = true;
+        valor.como_cadena(destino);
+    };
+    decodificar(usuario_origen, t.usuario_origen);
+    decodificar(usuario_destino, t.usuario_destino);
+    decodificar(tipo, t.tipo);
+    decodificar(fecha, t.fecha);
+    return t;
+}
+
+std::vector<TransaccionDB> HistorialMapeado::a_transacciones(size_t hilos) const {
+    std::vector<TransaccionDB> transacciones(registros.size());
+    size_t partes = partes_para(registros.size(), 65536, hilos);
+    ejecutar_en_paralelo(partes, [&](size_t parte) {
+        size_t hasta = registros.size() * (parte + 1) / partes;
+        for (size_t i = registros.size() * parte / partes; i < hasta; ++i) {
+            transacciones[i] = registros[i].a_transaccion();
+        }
+    });
+    return transacciones;
+}
+
+const size_t* VersionUsuarios::buscar(const Indice& indice, const Indice& recientes, const std::string& clave) {
+    auto it = indice.find(clave);
+    if (it != indice.end()) return &it->second;
+    it = recientes.find(clave);
+    return (it == recientes.end()) ? nullptr : &it->second;
+}
+
+const UsuarioDB* VersionUsuarios::buscar_nombre(const std::string& nombre) const {
+    if (filtro_nombres && !filtro_nombres->puede_contener(nombre)) return nullptr;
+    const size_t* posicion = buscar(*indice_nombre, *recientes_nombre, nombre);
+    return posicion ? &(*this)[*posicion] : nullptr;
+}
+
+const UsuarioDB* VersionUsuarios::buscar_cuenta(const std::string& cuenta_id) const {
+    if (filtro_cuentas && !filtro_cuentas->puede_contener(cuenta_id)) return nullptr;
+    const size_t* posicion = buscar(*indice_cuenta, *recientes_cuenta, cuenta_id);
+    return posicion ? &(*this)[*posicion] : nullptr;
+}
+
+std::vector<UsuarioDB> VersionUsuarios::a_vector() const {
+    std::vector<UsuarioDB> copia;
+    copia.reserve(cantidad);
+    for (const auto& pagina : paginas) {
+        copia.insert(copia.end(), pagina->begin(), pagina->end());
+    }
+    return copia;
+}
+
+CursorTransacciones RangoTransacciones::begin() const {
+    CursorTransacciones cursor;
+    if (!archivo) return cursor;
+    cursor.segmentos = &segmentos;
+    cursor.archivo = archivo.get();
+    cursor.contenido = archivo->contenido();
+    cursor.siguiente = std::min(inicio_log, cursor.contenido.size());
+    cursor.fin = false;
+    cursor.avanzar();
+    return cursor;
+}
+
+void CursorTransacciones::avanzar() {
+    // Primero el historial archivado, en orden, y después el log
+    while (segmento < segmentos->size()) {
+        const SegmentoColumnar& actual_segmento = *(*segmentos)[segmento];
+        // Se decodifica un bloque por vez, a medida que el recorrido llega,
+        // y se suelta al pasar al siguiente
+        if (fila < actual_segmento.size()) {
+            if (!bloque || !bloque->contiene(fila)) bloque = actual_segmento.bloque_de(fila);
+            if (bloque) {
+                actual = actual_segmento.vista(*bloque, fila++);
+                return;
+            }
+        }
+        segmento++;
+        fila = 0;
+        bloque.reset();
+    }
+    
+    // Cada tanto se devuelven al sistema las páginas ya recorridas, para que
+    // un recorrido completo no deje el log entero residente
+    const size_t tramo_descarte = 16 * 1024 * 1024;
+    if (siguiente - descartado >= tramo_descarte) {
+        archivo->descartar_hasta(siguiente);
+        descartado = siguiente;
+    }
+    
+    std::string_view json;
+    while (siguiente < contenido.size()) {
+        size_t fin_linea = contenido.find('\n', siguiente);
+        if (fin_linea == std::string_view::npos) break;
+        std::string_view linea = contenido.substr(siguiente, fin_linea - siguiente);
+        siguiente = fin_linea + 1;
+        if (DatabaseJSON::desenmarcar_registro(linea, json) && parsear_vista(json, actual)) {
+            return;
+        }
+    }
+    fin = true;
+}
 
 DatabaseJSON::DatabaseJSON(const std::string& archivo_usuarios, 
                            const std::string& archivo_transacciones)
     : archivo_usuarios(archivo_usuarios), 
-      archivo_transacciones(archivo_transacciones) {
+      archivo_log_usuarios(archivo_usuarios + ".log"),
+      archivo_checkpoint(archivo_usuarios + ".chk"),
+      archivo_transacciones(archivo_transacciones),
+      archivo_log_transacciones(archivo_transacciones + ".log"),
+      archivo_indice_usuarios(archivo_transacciones + ".idx"),
+      archivo_secuencia_ids(archivo_transacciones + ".seq"),
+      prefijo_segmentos(archivo_transacciones + ".seg.") {
     inicializar_archivos();
+    hilo_checkpoint = std::thread(&DatabaseJSON::ejecutar_checkpoints, this);
+}
+
+DatabaseJSON::~DatabaseJSON() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        detener_checkpoint = true;
+    }
+    cv_checkpoint.notify_all();
+    if (hilo_checkpoint.joinable()) hilo_checkpoint.join();
+    
+    // transacciones.json (formato de arreglo) se regenera al cerrar, si se
+    // pidió y el historial cambió, para las herramientas que todavía lo leen
+    bool exportar = false;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        exportar = exportar_al_cerrar && cambios_historial != cambios_exportados && escritor_log;
+    }
+    if (exportar && !exportar_transacciones_json()) {
+        std::cerr << "[DB] No se pudo regenerar " << archivo_transacciones << std::endl;
+    }
+    
+    // Al cerrar, el snapshot queda al día (también los saldos diferidos) y
+    // el log de usuarios vacío
+    std::lock_guard<std::mutex> lock(mtx);
+    if (cambios_sin_checkpoint > 0 || !saldos_sucios.empty()) checkpoint_sin_lock();
 }
 
 std::string DatabaseJSON::obtener_fecha_actual() {
@@ -19,348 +381,2111 @@ std::string DatabaseJSON::obtener_fecha_actual() {
 
 std::string DatabaseJSON::escapar_json(const std::string& str) {
     std::string resultado;
-    for (char c : str) {
-        if (c == '"' || c == '\\') {
-            resultado += '\\';
+    resultado.reserve(str.size());
+    SerializadorJSON::escapar(str, resultado);
+    return resultado;
+}
+
+void DatabaseJSON::serializar_registro(const RegistroLog& registro, SerializadorJSON& destino) {
+    const TransaccionDB& t = registro.transaccion;
+    destino.abrir_registro();
+    destino.literal("{\"lsn\":");
+    destino.natural(registro.lsn);
+    destino.literal(",\"id\":");
+    destino.entero(t.id);
+    destino.literal(",\"usuario_origen\":");
+    destino.cadena(t.usuario_origen);
+    destino.literal(",\"usuario_destino\":");
+    destino.cadena(t.usuario_destino);
+    destino.literal(",\"monto\":");
+    destino.monto(t.monto);
+    destino.literal(",\"tipo\":");
+    destino.cadena(t.tipo);
+    destino.literal(",\"es_sospechosa\":");
+    destino.booleano(t.es_sospechosa);
+    destino.literal(",\"fecha\":");
+    destino.cadena(t.fecha);
+    if (registro.con_saldos) {
+        // Saldos absolutos tras aplicar la transferencia (se reaplican al arrancar)
+        destino.literal(",\"saldo_origen\":");
+        destino.monto(registro.saldo_origen);
+        destino.literal(",\"saldo_destino\":");
+        destino.monto(registro.saldo_destino);
+    }
+    destino.literal("}");
+    destino.cerrar_registro();
+}
+
+bool DatabaseJSON::parsear_transaccion(std::string_view json, TransaccionDB& t) {
+    unsigned campos = 0;
+    LectorJSON lector(json);
+    bool leido = lector.recorrer_objeto([&](std::string_view clave, const ValorJSON& valor) {
+        campos |= asignar_campo_transaccion(clave, valor, t);
+    });
+    return leido && campos == CAMPOS_TRANSACCION;
+}
+
+bool DatabaseJSON::parsear_registro(std::string_view json, RegistroLog& registro) {
+    registro = RegistroLog();
+    unsigned campos = 0;
+    bool valido = true;
+    bool con_saldo_destino = false;
+    
+    LectorJSON lector(json);
+    bool leido = lector.recorrer_objeto([&](std::string_view clave, const ValorJSON& valor) {
+        // Los registros migrados del formato anterior no llevan lsn
+        if (clave == "lsn") {
+            valido &= valor.como_entero(registro.lsn);
+        } else if (clave == "saldo_origen") {
+            registro.con_saldos = true;
+            valido &= valor.como_double(registro.saldo_origen);
+        } else if (clave == "saldo_destino") {
+            con_saldo_destino = true;
+            valido &= valor.como_double(registro.saldo_destino);
+        } else {
+            campos |= asignar_campo_transaccion(clave, valor, registro.transaccion);
         }
-        resultado += c;
+    });
+    return leido && valido && campos == CAMPOS_TRANSACCION &&
+           registro.con_saldos == con_saldo_destino;
+}
+
+void DatabaseJSON::serializar_saldo(const RegistroSaldo& registro, SerializadorJSON& destino) {
+    const UsuarioDB& u = registro.usuario;
+    destino.abrir_registro();
+    destino.literal("{\"lsn\":");
+    destino.natural(registro.lsn);
+    destino.literal(registro.alta ? ",\"op\":\"alta\"" : ",\"op\":\"saldo\"");
+    destino.literal(",\"saldo\":");
+    destino.monto(u.saldo);
+    destino.literal(",\"nombre\":");
+    destino.cadena(u.nombre);
+    if (registro.alta) {
+        destino.literal(",\"cuenta_id\":");
+        destino.cadena(u.cuenta_id);
+        destino.literal(",\"fecha_creacion\":");
+        destino.cadena(u.fecha_creacion);
     }
-    return resultado;
+    destino.literal("}");
+    destino.cerrar_registro();
+}
+
+bool DatabaseJSON::parsear_saldo(std::string_view json, RegistroSaldo& registro) {
+    registro = RegistroSaldo();
+    registro.usuario = UsuarioDB{"", "", 0.0, ""};
+    bool valido = true;
+    bool con_lsn = false;
+    bool con_saldo = false;
+    bool con_nombre = false;
+    std::string_view op;
+    
+    LectorJSON lector(json);
+    bool leido = lector.recorrer_objeto([&](std::string_view clave, const ValorJSON& valor) {
+        if (clave == "lsn") {
+            con_lsn = valor.como_entero(registro.lsn);
+        } else if (clave == "op") {
+            op = valor.texto;
+        } else if (clave == "saldo") {
+            con_saldo = valor.como_double(registro.usuario.saldo);
+        } else if (clave == "nombre") {
+            con_nombre = valor.como_cadena(registro.usuario.nombre);
+        } else if (clave == "cuenta_id" || clave == "fecha_creacion") {
+            valido &= asignar_campo_usuario(clave, valor, registro.usuario);
+        }
+    });
+    registro.alta = (op == "alta");
+    return leido && valido && con_lsn && con_saldo && con_nombre && (registro.alta || op == "saldo");
+}
+
+bool DatabaseJSON::agregar_al_log_usuarios(const RegistroSaldo& registro, EscritorLog::Ticket& ticket) {
+    if (!escritor_usuarios) return false;
+    serializador.limpiar();
+    serializar_saldo(registro, serializador);
+    return escritor_usuarios->agregar(serializador.texto(), ticket);
+}
+
+bool DatabaseJSON::agregar_al_log(const RegistroLog& registro, EscritorLog::Ticket& ticket) {
+    if (!escritor_log) return false;
+    // Un id no positivo viene de una reserva fallida (reservar_ids devolvió -1)
+    if (registro.transaccion.id < 1) return false;
+    // Un id elegido por el llamador por encima del techo lo amplía antes de
+    // llegar al log: al arrancar basta con mirar la cola
+    if (!avanzar_secuencia_ids(registro.transaccion.id)) return false;
+    
+    // El orden del log lo fija este append (hecho con mtx tomado); la espera
+    // por el fsync la hace el llamador después de soltar el lock
+    serializador.limpiar();
+    serializar_registro(registro, serializador);
+    if (!escritor_log->agregar(serializador.texto(), ticket)) return false;
+    // Aceptado, ya lo ve cualquier lector nuevo (mapear_log escribe el lote)
+    version_datos++;
+    cambios_historial++;
+    
+    uint64_t offset = tam_log;
+    tam_log += serializador.size();
+    indexar_registro(offset, registro.transaccion, segundos_de(registro.transaccion.fecha), true);
+    return true;
 }
 
-std::string DatabaseJSON::trim(const std::string& str) {
-    size_t first = str.find_first_not_of(" \t\n\r");
-    if (first == std::string::npos) return "";
-    size_t last = str.find_last_not_of(" \t\n\r");
-    return str.substr(first, last - first + 1);
+bool DatabaseJSON::desenmarcar_registro(std::string_view linea, std::string_view& json) {
+    const size_t largo_cabecera = 18;
+    if (linea.size() < largo_cabecera || linea[8] != ' ' || linea[17] != ' ') return false;
+    
+    size_t longitud = 0;
+    uint32_t crc = 0;
+    auto r1 = std::from_chars(linea.data(), linea.data() + 8, longitud, 16);
+    auto r2 = std::from_chars(linea.data() + 9, linea.data() + 17, crc, 16);
+    if (r1.ec != std::errc() || r1.ptr != linea.data() + 8) return false;
+    if (r2.ec != std::errc() || r2.ptr != linea.data() + 17) return false;
+    
+    if (linea.size() - largo_cabecera != longitud) return false;
+    if (io_archivos::calcular_crc32(linea.data() + largo_cabecera, longitud) != crc) return false;
+    
+    json = linea.substr(largo_cabecera, longitud);
+    return true;
 }
 
 void DatabaseJSON::inicializar_archivos() {
     std::lock_guard<std::mutex> lock(mtx);
     
+    // Cerrar los escritores anteriores antes de recuperar. El del log de
+    // transacciones puede seguir vivo en manos de un lector: se vuelca antes.
+    if (escritor_log) escritor_log->sincronizar();
+    escritor_log.reset();
+    escritor_usuarios.reset();
+    
+    // Un reemplazo interrumpido deja el original intacto y un temporal a medias
+    limpiar_temporales();
+    
     // Inicializar archivo de usuarios si no existe
     std::ifstream test_usuarios(archivo_usuarios);
     if (!test_usuarios.good()) {
-        std::ofstream usuarios(archivo_usuarios);
-        usuarios << "[\n]\n";
-        usuarios.close();
+        io_archivos::reemplazar_archivo(archivo_usuarios, "[\n]\n");
     }
     test_usuarios.close();
     
     // Inicializar archivo de transacciones si no existe
     std::ifstream test_transacciones(archivo_transacciones);
     if (!test_transacciones.good()) {
-        std::ofstream transacciones(archivo_transacciones);
-        transacciones << "[\n]\n";
-        transacciones.close();
+        io_archivos::reemplazar_archivo(archivo_transacciones, "[\n]\n");
     }
     test_transacciones.close();
-}
-
-bool DatabaseJSON::guardar_usuario(const UsuarioDB& usuario) {
-    std::lock_guard<std::mutex> lock(mtx);
     
-    // Cargar usuarios existentes
-    auto usuarios = cargar_usuarios();
-    
-    // Verificar si ya existe
-    for (const auto& u : usuarios) {
-        if (u.nombre == usuario.nombre) {
-            return false; // Usuario ya existe
+    // Crear el log de transacciones, migrando el historial del formato anterior
+    std::ifstream test_log(archivo_log_transacciones);
+    if (!test_log.good()) {
+        SerializadorJSON log;
+        RegistroLog registro;
+        for (const auto& t : cargar_transacciones_legado()) {
+            registro.lsn++;
+            registro.transaccion = t;
+            serializar_registro(registro, log);
+        }
+        if (!io_archivos::reemplazar_archivo(archivo_log_transacciones, log.texto())) {
+            std::cerr << "[DB] No se pudo crear " << archivo_log_transacciones << std::endl;
         }
     }
+    test_log.close();
     
-    // Agregar nuevo usuario
-    usuarios.push_back(usuario);
-    
-    // Guardar archivo
-    std::ofstream archivo(archivo_usuarios);
-    if (!archivo.is_open()) return false;
+    // Segmentos archivados; si el último se escribió pero el log no llegó a
+    // recortarse, se recorta ahora (antes de leer el checkpoint)
+    cargar_segmentos();
+    completar_archivado();
     
-    archivo << "[\n";
+    // La tabla de usuarios parte del último snapshot y queda residente
+    usuarios = cargar_usuarios_archivo(lsn_usuarios);
+    indice_nombre.clear();
+    indice_cuenta.clear();
+    filtro_nombres.reset();
+    filtro_cuentas.reset();
+    ultimo_lsn = 0;
     for (size_t i = 0; i < usuarios.size(); ++i) {
-        archivo << "  {\n";
-        archivo << "    \"nombre\": \"" << escapar_json(usuarios[i].nombre) << "\",\n";
-        archivo << "    \"cuenta_id\": \"" << escapar_json(usuarios[i].cuenta_id) << "\",\n";
-        archivo << "    \"saldo\": " << std::fixed << std::setprecision(2) << usuarios[i].saldo << ",\n";
-        archivo << "    \"fecha_creacion\": \"" << escapar_json(usuarios[i].fecha_creacion) << "\"\n";
-        archivo << "  }";
-        if (i < usuarios.size() - 1) archivo << ",";
-        archivo << "\n";
-    }
-    archivo << "]\n";
-    archivo.close();
+        indexar_usuario(i);
+        ultimo_lsn = std::max(ultimo_lsn, lsn_usuarios[i]);
+    }
     
-    return true;
+    // Sobre el snapshot se reaplica solo la cola: los saldos de las
+    // transferencias posteriores al checkpoint y el log de usuarios. Ambos
+    // logs comparten la secuencia de lsn, así que se aplican en ese orden.
+    std::vector<RegistroSaldo> cambios;
+    recuperar_log_transacciones(cambios);
+    recuperar_log_usuarios(cambios);
+    std::stable_sort(cambios.begin(), cambios.end(),
+                     [](const RegistroSaldo& a, const RegistroSaldo& b) { return a.lsn < b.lsn; });
+    size_t aplicados = 0;
+    for (const auto& cambio : cambios) {
+        aplicados += aplicar_cambio_usuario(cambio);
+    }
+    cambios_sin_checkpoint = cambios.size();
+    
+    if (aplicados > 0) {
+        std::cout << "[DB] " << aplicados
+                  << " cambios de usuarios reaplicados sobre el snapshot" << std::endl;
+    }
+    
+    cargar_indice_usuarios();
+    recuperar_secuencia_ids();
+    
+    escritor_log = std::make_shared<EscritorLog>(archivo_log_transacciones, modo_durabilidad);
+    escritor_usuarios = std::make_unique<EscritorLog>(archivo_log_usuarios, modo_durabilidad);
+    
+    // La tabla recién cargada se publica entera, partiendo de una versión vacía
+    std::atomic_store(&usuarios_publicados, std::make_shared<const VersionUsuarios>());
+    publicar_usuarios({});
+    publicar_historial(0);
 }
 
-bool DatabaseJSON::actualizar_saldo(const std::string& nombre, double nuevo_saldo) {
-    std::lock_guard<std::mutex> lock(mtx);
+void DatabaseJSON::limpiar_temporales() {
+    std::vector<std::string> temporales;
+    for (const std::string* ruta : {&archivo_usuarios, &archivo_log_usuarios, &archivo_checkpoint,
+                                    &archivo_transacciones, &archivo_log_transacciones,
+                                    &archivo_indice_usuarios, &archivo_secuencia_ids}) {
+        temporales.push_back(io_archivos::ruta_temporal(*ruta));
+    }
     
-    auto usuarios = cargar_usuarios();
-    bool encontrado = false;
+    // Los segmentos en escritura son "<prefijo><número>.tmp"
+    std::filesystem::path prefijo(prefijo_segmentos);
+    std::filesystem::path directorio = prefijo.parent_path();
+    std::string nombre_prefijo = prefijo.filename().string();
+    std::string_view sufijo = io_archivos::SUFIJO_TEMPORAL;
+    std::error_code ec;
+    for (const auto& entrada : std::filesystem::directory_iterator(
+             directorio.empty() ? std::filesystem::path(".") : directorio, ec)) {
+        std::string nombre = entrada.path().filename().string();
+        if (nombre.size() > nombre_prefijo.size() + sufijo.size() &&
+            nombre.compare(0, nombre_prefijo.size(), nombre_prefijo) == 0 &&
+            nombre.compare(nombre.size() - sufijo.size(), sufijo.size(), sufijo) == 0) {
+            temporales.push_back(entrada.path().string());
+        }
+    }
     
-    for (auto& u : usuarios) {
-        if (u.nombre == nombre) {
-            u.saldo = nuevo_saldo;
-            encontrado = true;
-            break;
+    for (const auto& temporal : temporales) {
+        if (std::filesystem::remove(temporal, ec)) {
+            std::cout << "[DB] Reemplazo interrumpido descartado: " << temporal << std::endl;
+        }
+    }
+}
+
+void DatabaseJSON::indexar_registro(uint64_t offset, const TransaccionDB& t, int64_t segundos, bool persistir) {
+    {
+        std::lock_guard<std::mutex> lock_indice(mtx_indice);
+        offsets_por_usuario[t.usuario_origen].push_back(offset);
+        if (t.usuario_destino != t.usuario_origen) {
+            offsets_por_usuario[t.usuario_destino].push_back(offset);
+        }
+        
+        if (tramos_tiempo.empty() || tramos_tiempo.back().registros == REGISTROS_POR_TRAMO) {
+            int64_t acumulado = tramos_tiempo.empty() ? INT64_MIN : tramos_tiempo.back().maximo_acumulado;
+            tramos_tiempo.push_back(TramoTiempo{offset, INT64_MAX, INT64_MIN, acumulado, 0});
+        }
+        TramoTiempo& tramo = tramos_tiempo.back();
+        tramo.registros++;
+        if (segundos != marcas_tiempo::SIN_FECHA) {
+            tramo.desde = std::min(tramo.desde, segundos);
+            tramo.hasta = std::max(tramo.hasta, segundos);
         }
+        tramo.maximo_acumulado = std::max(tramo.maximo_acumulado, tramo.hasta);
+    }
+    fin_indexado = std::max(fin_indexado, offset + 1);
+    
+    if (persistir) {
+        std::string linea;
+        agregar_linea_indice(linea, offset, t, segundos);
+        escribir_lineas_indice(linea);
+    }
+}
+
+void DatabaseJSON::agregar_linea_indice(std::string& destino, uint64_t offset,
+                                        const TransaccionDB& t, int64_t segundos) {
+    // Una línea por registro: "<offset>\t<origen>\t<destino>\t<segundos>"
+    // ('-' si la fecha no es canónica)
+    char numero[24];
+    destino.append(numero, std::to_chars(numero, numero + sizeof(numero), offset).ptr);
+    destino += '\t';
+    destino += t.usuario_origen;
+    destino += '\t';
+    destino += t.usuario_destino;
+    destino += '\t';
+    if (segundos == marcas_tiempo::SIN_FECHA) destino += '-';
+    else destino.append(numero, std::to_chars(numero, numero + sizeof(numero), segundos).ptr);
+    destino += '\n';
+}
+
+void DatabaseJSON::escribir_lineas_indice(const std::string& lineas) {
+    // Si no llega al archivo, cargar_indice_usuarios reindexa desde el log
+    std::ofstream indice(archivo_indice_usuarios, std::ios::app | std::ios::binary);
+    indice.write(lineas.data(), static_cast<std::streamsize>(lineas.size()));
+}
+
+void DatabaseJSON::cargar_indice_usuarios() {
+    {
+        std::lock_guard<std::mutex> lock_indice(mtx_indice);
+        offsets_por_usuario.clear();
+        tramos_tiempo.clear();
     }
+    fin_indexado = 0;
     
-    if (!encontrado) return false;
+    std::ifstream indice(archivo_indice_usuarios, std::ios::binary);
+    std::string linea;
+    std::streamoff valido = 0;
+    while (std::getline(indice, linea) && !indice.eof()) {
+        size_t tab1 = linea.find('\t');
+        size_t tab2 = (tab1 == std::string::npos) ? tab1 : linea.find('\t', tab1 + 1);
+        size_t tab3 = (tab2 == std::string::npos) ? tab2 : linea.find('\t', tab2 + 1);
+        if (tab3 == std::string::npos) break;
+        
+        // Las entradas que apuntan más allá del log (log truncado) se descartan
+        uint64_t offset = std::strtoull(linea.c_str(), nullptr, 10);
+        if (offset >= tam_log) break;
+        
+        int64_t segundos = (linea.compare(tab3 + 1, std::string::npos, "-") == 0)
+                               ? marcas_tiempo::SIN_FECHA
+                               : std::strtoll(linea.c_str() + tab3 + 1, nullptr, 10);
+        
+        TransaccionDB t;
+        t.usuario_origen = linea.substr(tab1 + 1, tab2 - tab1 - 1);
+        t.usuario_destino = linea.substr(tab2 + 1, tab3 - tab2 - 1);
+        indexar_registro(offset, t, segundos, false);
+        valido = indice.tellg();
+    }
+    indice.close();
     
-    // Guardar archivo actualizado
-    std::ofstream archivo(archivo_usuarios);
-    if (!archivo.is_open()) return false;
+    std::error_code ec;
+    auto tamanio = std::filesystem::file_size(archivo_indice_usuarios, ec);
+    if (!ec && tamanio != static_cast<uintmax_t>(valido)) {
+        std::filesystem::resize_file(archivo_indice_usuarios, valido, ec);
+    }
     
-    archivo << "[\n";
-    for (size_t i = 0; i < usuarios.size(); ++i) {
-        archivo << "  {\n";
-        archivo << "    \"nombre\": \"" << escapar_json(usuarios[i].nombre) << "\",\n";
-        archivo << "    \"cuenta_id\": \"" << escapar_json(usuarios[i].cuenta_id) << "\",\n";
-        archivo << "    \"saldo\": " << std::fixed << std::setprecision(2) << usuarios[i].saldo << ",\n";
-        archivo << "    \"fecha_creacion\": \"" << escapar_json(usuarios[i].fecha_creacion) << "\"\n";
-        archivo << "  }";
-        if (i < usuarios.size() - 1) archivo << ",";
-        archivo << "\n";
-    }
-    archivo << "]\n";
-    archivo.close();
+    // Indexar los registros del log que el índice todavía no cubre
+    // (índice inexistente, migración o caída entre el log y el índice)
+    ArchivoMapeado log(archivo_log_transacciones);
+    uint64_t inicio = (fin_indexado == 0) ? 0 : fin_indexado - 1;
+    if (!log.esta_abierto() || inicio >= log.contenido().size()) return;
     
-    return true;
+    size_t agregados = 0;
+    uint64_t offset = inicio;
+    recorrer_lineas(log.contenido().substr(inicio), [&](std::string_view linea, size_t fin) {
+        std::string_view json;
+        TransaccionDB t;
+        if (offset + 1 > fin_indexado && desenmarcar_registro(linea, json) &&
+            parsear_transaccion(json, t)) {
+            indexar_registro(offset, t, segundos_de(t.fecha), true);
+            agregados++;
+        }
+        offset = inicio + fin;
+    });
+    
+    if (agregados > 0) {
+        std::cout << "[DB] Índice por usuario actualizado con " << agregados
+                  << " registros del log" << std::endl;
+    }
 }
 
-std::vector<UsuarioDB> DatabaseJSON::cargar_usuarios() {
-    std::vector<UsuarioDB> usuarios;
+size_t DatabaseJSON::aplicar_cambio_usuario(const RegistroSaldo& registro) {
+    auto it = indice_nombre.find(registro.usuario.nombre);
+    if (registro.alta) {
+        if (it != indice_nombre.end()) return 0;
+        usuarios.push_back(registro.usuario);
+        lsn_usuarios.push_back(registro.lsn);
+        indexar_usuario(usuarios.size() - 1);
+        return 1;
+    }
     
-    std::ifstream archivo(archivo_usuarios);
-    if (!archivo.is_open()) return usuarios;
+    // Solo se aplica si el registro es posterior a lo que ya refleja el snapshot
+    if (it == indice_nombre.end() || registro.lsn <= lsn_usuarios[it->second]) return 0;
+    usuarios[it->second].saldo = registro.usuario.saldo;
+    lsn_usuarios[it->second] = registro.lsn;
+    return 1;
+}
+
+uint64_t DatabaseJSON::recuperar_log(const std::string& ruta, uint64_t desde,
+                                     const std::function<void(std::string_view)>& visitar) {
+    // Lo que sigue al último registro válido (caída durante un append) se
+    // descarta para que el siguiente append no quede pegado a un registro roto
+    std::ifstream archivo(ruta, std::ios::binary);
+    if (!archivo.is_open()) return 0;
     
-    std::string linea;
-    UsuarioDB usuario_actual;
-    bool leyendo_usuario = false;
+    // Solo se confía en 'desde' si cae justo después de un fin de línea
+    if (desde > 0) {
+        char anterior = 0;
+        archivo.seekg(static_cast<std::streamoff>(desde - 1));
+        if (!archivo.get(anterior) || anterior != '\n') {
+            std::cerr << "[DB] Punto de control inválido para " << ruta
+                      << "; se recorre el log completo" << std::endl;
+            desde = 0;
+        }
+    }
+    archivo.close();
     
-    while (std::getline(archivo, linea)) {
-        linea = trim(linea);
-        
-        if (linea == "{") {
-            leyendo_usuario = true;
-            usuario_actual = UsuarioDB();
-        } else if (linea == "}" || linea == "},") {
-            if (leyendo_usuario) {
-                usuarios.push_back(usuario_actual);
-                leyendo_usuario = false;
-            }
-        } else if (leyendo_usuario) {
-            size_t pos_colon = linea.find(':');
-            if (pos_colon != std::string::npos) {
-                std::string clave = trim(linea.substr(0, pos_colon));
-                std::string valor = trim(linea.substr(pos_colon + 1));
-                
-                // Remover comillas y comas finales
-                clave.erase(std::remove(clave.begin(), clave.end(), '"'), clave.end());
-                if (!valor.empty() && valor.back() == ',') {
-                    valor = valor.substr(0, valor.length() - 1);
+    // La cola se recorre en el lugar sobre el archivo mapeado. El mapeo se
+    // libera antes de truncar.
+    uint64_t valido = desde;
+    {
+        ArchivoMapeado log(ruta);
+        std::string_view contenido = log.contenido();
+        if (desde < contenido.size()) {
+            recorrer_lineas(contenido.substr(desde), [&](std::string_view linea, size_t fin) {
+                std::string_view json;
+                if (desenmarcar_registro(linea, json)) {
+                    valido = desde + fin;
+                    visitar(json);
                 }
-                valor = trim(valor);
-                
-                if (clave == "nombre") {
-                    valor.erase(std::remove(valor.begin(), valor.end(), '"'), valor.end());
-                    usuario_actual.nombre = valor;
-                } else if (clave == "cuenta_id") {
-                    valor.erase(std::remove(valor.begin(), valor.end(), '"'), valor.end());
-                    usuario_actual.cuenta_id = valor;
-                } else if (clave == "saldo") {
-                    usuario_actual.saldo = std::stod(valor);
-                } else if (clave == "fecha_creacion") {
-                    valor.erase(std::remove(valor.begin(), valor.end(), '"'), valor.end());
-                    usuario_actual.fecha_creacion = valor;
-                }
-            }
+            });
         }
     }
     
-    archivo.close();
-    return usuarios;
+    std::error_code ec;
+    auto tamanio = std::filesystem::file_size(ruta, ec);
+    if (!ec && tamanio != static_cast<uintmax_t>(valido)) {
+        std::cerr << "[DB] " << ruta << " truncado en el byte " << valido
+                  << " (registro incompleto o corrupto)" << std::endl;
+        std::filesystem::resize_file(ruta, valido, ec);
+    }
+    return valido;
 }
 
-UsuarioDB DatabaseJSON::obtener_usuario(const std::string& nombre) {
-    auto usuarios = cargar_usuarios();
-    for (const auto& u : usuarios) {
-        if (u.nombre == nombre) {
-            return u;
-        }
+void DatabaseJSON::leer_checkpoint(uint64_t& lsn, uint64_t& offset) {
+    // Formato: "<lsn> <offset en el log de transacciones>"
+    std::ifstream archivo(archivo_checkpoint);
+    if (!(archivo >> lsn >> offset)) {
+        lsn = 0;
+        offset = 0;
     }
-    return UsuarioDB{"", "", -1.0, ""};
 }
 
+void DatabaseJSON::recuperar_log_transacciones(std::vector<RegistroSaldo>& cambios) {
+    // Lo anterior al checkpoint ya está en el snapshot: solo se recorre la cola
+    uint64_t lsn_checkpoint = 0;
+    uint64_t offset_checkpoint = 0;
+    leer_checkpoint(lsn_checkpoint, offset_checkpoint);
+    ultimo_lsn = std::max(ultimo_lsn, lsn_checkpoint);
+    
+    RegistroLog registro;
+    tam_log = recuperar_log(archivo_log_transacciones, offset_checkpoint,
+                            [&](std::string_view json) {
+        if (!parsear_registro(json, registro)) return;
+        ultimo_lsn = std::max(ultimo_lsn, registro.lsn);
+        if (!registro.con_saldos) return;
+        
+        RegistroSaldo cambio;
+        cambio.lsn = registro.lsn;
+        cambio.usuario.nombre = registro.transaccion.usuario_origen;
+        cambio.usuario.saldo = registro.saldo_origen;
+        cambios.push_back(cambio);
+        cambio.usuario.nombre = registro.transaccion.usuario_destino;
+        cambio.usuario.saldo = registro.saldo_destino;
+        cambios.push_back(cambio);
+    });
+}
 
-UsuarioDB DatabaseJSON::obtener_usuario_por_cuenta(const std::string& cuenta_id) {
-    std::lock_guard<std::mutex> lock(mtx);
-
-    auto usuarios = cargar_usuarios();
-    for (const auto& u : usuarios) {
-        if (u.cuenta_id == cuenta_id) {
-            return u;
+void DatabaseJSON::recuperar_log_usuarios(std::vector<RegistroSaldo>& cambios) {
+    RegistroSaldo registro;
+    recuperar_log(archivo_log_usuarios, 0, [&](std::string_view json) {
+        if (parsear_saldo(json, registro)) {
+            ultimo_lsn = std::max(ultimo_lsn, registro.lsn);
+            cambios.push_back(registro);
         }
-    }
-
-    // Usuario no encontrado
-    return UsuarioDB{"", "", -1.0, ""};
+    });
 }
 
-bool DatabaseJSON::usuario_existe(const std::string& nombre) {
-    auto usuarios = cargar_usuarios();
-    for (const auto& u : usuarios) {
-        if (u.nombre == nombre) {
-            return true;
-        }
+void DatabaseJSON::registrar_cambio_sin_checkpoint() {
+    if (++cambios_sin_checkpoint == umbral_checkpoint) {
+        cv_checkpoint.notify_one();
     }
-    return false;
 }
 
-bool DatabaseJSON::guardar_transaccion(const TransaccionDB& transaccion) {
-    std::lock_guard<std::mutex> lock(mtx);
+bool DatabaseJSON::checkpoint_sin_lock() {
+    if (!escritor_log || !escritor_usuarios) return false;
     
-    auto transacciones = cargar_transacciones();
-    transacciones.push_back(transaccion);
+    // El snapshot no puede adelantarse a los logs: lo que refleja tiene que
+    // ser durable antes de escribirlo
+    if (!escritor_log->sincronizar() || !escritor_usuarios->sincronizar()) return false;
+    if (!escribir_usuarios()) return false;
     
-    std::ofstream archivo(archivo_transacciones);
-    if (!archivo.is_open()) return false;
-    
-    archivo << "[\n";
-    for (size_t i = 0; i < transacciones.size(); ++i) {
-        archivo << "  {\n";
-        archivo << "    \"id\": " << transacciones[i].id << ",\n";
-        archivo << "    \"usuario_origen\": \"" << escapar_json(transacciones[i].usuario_origen) << "\",\n";
-        archivo << "    \"usuario_destino\": \"" << escapar_json(transacciones[i].usuario_destino) << "\",\n";
-        archivo << "    \"monto\": " << std::fixed << std::setprecision(2) << transacciones[i].monto << ",\n";
-        archivo << "    \"tipo\": \"" << escapar_json(transacciones[i].tipo) << "\",\n";
-        archivo << "    \"es_sospechosa\": " << (transacciones[i].es_sospechosa ? "true" : "false") << ",\n";
-        archivo << "    \"fecha\": \"" << escapar_json(transacciones[i].fecha) << "\"\n";
-        archivo << "  }";
-        if (i < transacciones.size() - 1) archivo << ",";
-        archivo << "\n";
-    }
-    archivo << "]\n";
-    archivo.close();
+    std::ostringstream punto;
+    punto << ultimo_lsn << " " << tam_log << "\n";
+    if (!io_archivos::reemplazar_archivo(archivo_checkpoint, punto.str())) return false;
     
+    // Los deltas ya están en el snapshot: el log de usuarios se vacía.
+    // Si se cae antes, al arrancar se reaplican y se ignoran por lsn.
+    // El snapshot también lleva los saldos diferidos: no queda nada que volcar.
+    if (!escritor_usuarios->truncar()) return false;
+    cambios_sin_checkpoint = 0;
+    saldos_sucios.clear();
     return true;
 }
 
-std::vector<TransaccionDB> DatabaseJSON::cargar_transacciones(int limite) {
-    std::vector<TransaccionDB> transacciones;
-    
-    std::ifstream archivo(archivo_transacciones);
-    if (!archivo.is_open()) return transacciones;
-    
-    std::string linea;
-    TransaccionDB transaccion_actual;
-    bool leyendo_transaccion = false;
-    
-    while (std::getline(archivo, linea)) {
-        linea = trim(linea);
+void DatabaseJSON::ejecutar_checkpoints() {
+    using reloj = std::chrono::steady_clock;
+    std::unique_lock<std::mutex> lock(mtx);
+    reloj::time_point ultimo_checkpoint = reloj::now();
+    while (!detener_checkpoint) {
+        // Despierta por intervalo, cuando vence el saldo diferido más antiguo
+        // o cuando los cambios alcanzan su umbral
+        reloj::time_point despertar = ultimo_checkpoint + intervalo_checkpoint;
+        if (!saldos_sucios.empty()) {
+            despertar = std::min(despertar, primer_sucio + intervalo_volcado);
+        }
+        cv_checkpoint.wait_until(lock, despertar);
+        if (detener_checkpoint) break;
         
-        if (linea == "{") {
-            leyendo_transaccion = true;
-            transaccion_actual = TransaccionDB();
-        } else if (linea == "}" || linea == "},") {
-            if (leyendo_transaccion) {
-                transacciones.push_back(transaccion_actual);
-                leyendo_transaccion = false;
-            }
-        } else if (leyendo_transaccion) {
-            size_t pos_colon = linea.find(':');
-            if (pos_colon != std::string::npos) {
-                std::string clave = trim(linea.substr(0, pos_colon));
-                std::string valor = trim(linea.substr(pos_colon + 1));
-                
-                clave.erase(std::remove(clave.begin(), clave.end(), '"'), clave.end());
-                if (!valor.empty() && valor.back() == ',') {
-                    valor = valor.substr(0, valor.length() - 1);
-                }
-                valor = trim(valor);
-                
-                if (clave == "id") {
-                    transaccion_actual.id = std::stoi(valor);
-                } else if (clave == "usuario_origen") {
-                    valor.erase(std::remove(valor.begin(), valor.end(), '"'), valor.end());
-                    transaccion_actual.usuario_origen = valor;
-                } else if (clave == "usuario_destino") {
-                    valor.erase(std::remove(valor.begin(), valor.end(), '"'), valor.end());
-                    transaccion_actual.usuario_destino = valor;
-                } else if (clave == "monto") {
-                    transaccion_actual.monto = std::stod(valor);
-                } else if (clave == "tipo") {
-                    valor.erase(std::remove(valor.begin(), valor.end(), '"'), valor.end());
-                    transaccion_actual.tipo = valor;
-                } else if (clave == "es_sospechosa") {
-                    transaccion_actual.es_sospechosa = (valor == "true");
-                } else if (clave == "fecha") {
-                    valor.erase(std::remove(valor.begin(), valor.end(), '"'), valor.end());
-                    transaccion_actual.fecha = valor;
-                }
+        reloj::time_point ahora = reloj::now();
+        if (!saldos_sucios.empty() &&
+            (saldos_sucios.size() >= umbral_volcado || ahora >= primer_sucio + intervalo_volcado)) {
+            // La durabilidad la da el escritor según el modo; nadie espera
+            EscritorLog::Ticket ticket;
+            size_t volcados = 0;
+            if (!volcar_saldos_sin_lock(ticket, volcados)) {
+                std::cerr << "[DB] No se pudieron volcar los saldos diferidos" << std::endl;
             }
         }
+        
+        if (ahora < ultimo_checkpoint + intervalo_checkpoint &&
+            cambios_sin_checkpoint < umbral_checkpoint) {
+            continue;
+        }
+        ultimo_checkpoint = ahora;
+        if (cambios_sin_checkpoint > 0 && !checkpoint_sin_lock()) {
+            std::cerr << "[DB] Checkpoint de usuarios fallido; se reintentará" << std::endl;
+        }
+        if (umbral_archivado > 0 && tam_log >= umbral_archivado) {
+            archivar_sin_lock();
+        }
     }
+}
+
+bool DatabaseJSON::volcar_saldos_sin_lock(EscritorLog::Ticket& ticket, size_t& volcados) {
+    volcados = 0;
+    if (saldos_sucios.empty()) return true;
     
-    archivo.close();
+    // En orden de posición, para que el log no dependa del orden del hash
+    std::vector<size_t> posiciones(saldos_sucios.begin(), saldos_sucios.end());
+    std::sort(posiciones.begin(), posiciones.end());
     
-    // Limitar resultados
-    if (limite > 0 && transacciones.size() > static_cast<size_t>(limite)) {
-        transacciones.erase(transacciones.begin(), transacciones.end() - limite);
+    // Todos los registros van al log en un solo agregar (un solo write)
+    if (!escritor_usuarios) return false;
+    serializador.limpiar();
+    RegistroSaldo registro;
+    for (size_t i = 0; i < posiciones.size(); ++i) {
+        registro.lsn = ultimo_lsn + 1 + i;
+        registro.usuario.nombre = usuarios[posiciones[i]].nombre;
+        registro.usuario.saldo = usuarios[posiciones[i]].saldo;
+        serializar_saldo(registro, serializador);
     }
+    if (!escritor_usuarios->agregar(serializador.texto(), ticket)) return false;
     
-    return transacciones;
+    for (size_t posicion : posiciones) {
+        lsn_usuarios[posicion] = ++ultimo_lsn;
+        saldos_sucios.erase(posicion);
+        registrar_cambio_sin_checkpoint();
+        volcados++;
+    }
+    return true;
 }
 
-std::vector<TransaccionDB> DatabaseJSON::cargar_transacciones_usuario(const std::string& nombre, int limite) {
-    auto todas = cargar_transacciones(0);
-    std::vector<TransaccionDB> filtradas;
+bool DatabaseJSON::flush() {
+    std::unique_lock<std::mutex> lock(mtx);
+    EscritorLog::Ticket ticket;
+    size_t volcados = 0;
+    if (!volcar_saldos_sin_lock(ticket, volcados)) return false;
+    if (volcados == 0) return true;
     
-    for (const auto& t : todas) {
-        if (t.usuario_origen == nombre || t.usuario_destino == nombre) {
-            filtradas.push_back(t);
+    lock.unlock();
+    return escritor_usuarios->esperar_durable(ticket);
+}
+
+void DatabaseJSON::configurar_escritura_diferida(std::chrono::milliseconds intervalo, size_t umbral_sucios) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        intervalo_volcado = std::max(intervalo, std::chrono::milliseconds(0));
+        umbral_volcado = std::max<size_t>(1, umbral_sucios);
+    }
+    // Al pasar a escritura inmediata no puede quedar nada marcado
+    if (intervalo.count() <= 0) flush();
+    cv_checkpoint.notify_one();
+}
+
+bool DatabaseJSON::checkpoint() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return checkpoint_sin_lock();
+}
+
+void DatabaseJSON::configurar_checkpoint(std::chrono::milliseconds intervalo, size_t umbral_cambios) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        intervalo_checkpoint = intervalo;
+        umbral_checkpoint = std::max<size_t>(1, umbral_cambios);
+    }
+    cv_checkpoint.notify_one();
+}
+
+std::string DatabaseJSON::ruta_segmento(size_t numero) const {
+    char sufijo[16];
+    std::snprintf(sufijo, sizeof(sufijo), "%06zu", numero);
+    return prefijo_segmentos + sufijo;
+}
+
+std::vector<std::pair<size_t, std::string>> DatabaseJSON::listar_segmentos() const {
+    // Los segmentos son los archivos "<transacciones>.seg.<número>", en orden
+    std::filesystem::path prefijo(prefijo_segmentos);
+    std::filesystem::path directorio = prefijo.parent_path();
+    std::string nombre_prefijo = prefijo.filename().string();
+    std::vector<std::pair<size_t, std::string>> encontrados;
+    std::error_code ec;
+    for (const auto& entrada : std::filesystem::directory_iterator(
+             directorio.empty() ? std::filesystem::path(".") : directorio, ec)) {
+        std::string nombre = entrada.path().filename().string();
+        if (nombre.size() <= nombre_prefijo.size() ||
+            nombre.compare(0, nombre_prefijo.size(), nombre_prefijo) != 0) {
+            continue;
         }
+        std::string_view numero = std::string_view(nombre).substr(nombre_prefijo.size());
+        size_t valor = 0;
+        auto r = std::from_chars(numero.data(), numero.data() + numero.size(), valor);
+        if (r.ec != std::errc() || r.ptr != numero.data() + numero.size()) continue;
+        encontrados.emplace_back(valor, entrada.path().string());
     }
+    std::sort(encontrados.begin(), encontrados.end());
+    return encontrados;
+}
+
+void DatabaseJSON::cargar_segmentos() {
+    segmentos.clear();
+    siguiente_segmento = 1;
     
-    if (limite > 0 && filtradas.size() > static_cast<size_t>(limite)) {
-        filtradas.erase(filtradas.begin(), filtradas.end() - limite);
+    for (const auto& [numero, ruta] : listar_segmentos()) {
+        siguiente_segmento = std::max(siguiente_segmento, numero + 1);
+        auto segmento = std::make_shared<const SegmentoColumnar>(ruta);
+        if (!segmento->esta_abierto()) {
+            std::cerr << "[DB] Segmento " << ruta << " inválido; se ignora" << std::endl;
+            continue;
+        }
+        segmentos.push_back(std::move(segmento));
     }
-    
-    return filtradas;
 }
 
-int DatabaseJSON::obtener_siguiente_id_transaccion() {
-    auto transacciones = cargar_transacciones(0);
-    if (transacciones.empty()) return 1;
+void DatabaseJSON::completar_archivado() {
+    if (segmentos.empty()) return;
     
-    int max_id = 0;
-    for (const auto& t : transacciones) {
-        if (t.id > max_id) max_id = t.id;
+    std::string cola;
+    {
+        ArchivoMapeado log(archivo_log_transacciones);
+        const SegmentoColumnar& ultimo = *segmentos.back();
+        if (!ultimo.cubre_prefijo(log.contenido())) return;
+        cola.assign(log.contenido().substr(ultimo.bytes_prefijo()));
     }
     
-    return max_id + 1;
+    // El checkpoint apuntaba al log sin recortar: se recorre la cola completa
+    // (los saldos ya reflejados se descartan por lsn)
+    uint64_t lsn = 0;
+    uint64_t offset = 0;
+    leer_checkpoint(lsn, offset);
+    std::ostringstream punto;
+    punto << lsn << " 0\n";
+    std::error_code ec;
+    if (!io_archivos::reemplazar_archivo(archivo_checkpoint, punto.str()) ||
+        !io_archivos::reemplazar_archivo(archivo_log_transacciones, cola)) {
+        std::cerr << "[DB] No se pudo recortar el log ya archivado" << std::endl;
+        return;
+    }
+    std::filesystem::remove(archivo_indice_usuarios, ec);
+    std::cout << "[DB] Archivado interrumpido completado: log recortado" << std::endl;
 }
 
-bool DatabaseJSON::exportar_backup(const std::string& directorio) {
-    // Implementación simple de backup
-    std::string fecha = obtener_fecha_actual();
-    std::replace(fecha.begin(), fecha.end(), ' ', '_');
-    std::replace(fecha.begin(), fecha.end(), ':', '-');
+size_t DatabaseJSON::archivar_sin_lock() {
+    // Solo se archiva lo que ya refleja el snapshot: tras el checkpoint, el log
+    // completo (con mtx tomado nadie más escribe)
+    if (!escritor_log || !checkpoint_sin_lock() || tam_log == 0) return 0;
     
-    // Copiar archivos con timestamp
-    std::string backup_usuarios = directorio + "/usuarios_backup_" + fecha + ".json";
-    std::string backup_transacciones = directorio + "/transacciones_backup_" + fecha + ".json";
+    std::string contenido_segmento;
+    size_t archivados = 0;
+    {
+        ArchivoMapeado log(archivo_log_transacciones);
+        if (log.contenido().size() != tam_log) return 0;
+        
+        std::vector<TransaccionVista> registros;
+        TransaccionVista vista;
+        std::string_view json;
+        recorrer_lineas(log.contenido(), [&](std::string_view linea, size_t) {
+            if (desenmarcar_registro(linea, json) && parsear_vista(json, vista)) {
+                registros.push_back(vista);
+            }
+        });
+        if (registros.empty()) return 0;
+        contenido_segmento = SegmentoColumnar::codificar(registros, log.contenido());
+        archivados = registros.size();
+    }
+    
+    std::string ruta = ruta_segmento(siguiente_segmento);
+    std::error_code ec;
+    auto segmento = io_archivos::reemplazar_archivo(ruta, contenido_segmento)
+                        ? std::make_shared<const SegmentoColumnar>(ruta) : nullptr;
+    if (!segmento || !segmento->verificar() || segmento->size() != archivados) {
+        std::cerr << "[DB] No se pudo escribir el segmento " << ruta << std::endl;
+        std::filesystem::remove(ruta, ec);
+        return 0;
+    }
+    
+    // El segmento ya es durable. El checkpoint pasa al inicio del log antes
+    // de vaciarlo; si se cae entre ambos pasos, el arranque recorta el log
+    // (completar_archivado).
+    std::ostringstream punto;
+    punto << ultimo_lsn << " 0\n";
+    if (!io_archivos::reemplazar_archivo(archivo_checkpoint, punto.str())) {
+        std::filesystem::remove(ruta, ec);
+        return 0;
+    }
+    
+    // Los lectores pasan a ver el segmento antes de que el log se vacíe: la
+    // versión intermedia salta el prefijo archivado si todavía lo mapean
+    segmentos.push_back(std::move(segmento));
+    publicar_historial(tam_log);
+    if (!escritor_log->truncar()) {
+        // El escritor queda en error; en disco el estado es el de una caída
+        // antes de vaciar el log, que el próximo arranque completa
+        std::cerr << "[DB] No se pudo vaciar el log tras archivarlo" << std::endl;
+        siguiente_segmento++;
+        return 0;
+    }
+    
+    siguiente_segmento++;
+    tam_log = 0;
+    
+    // Los offsets del índice por usuario eran del log anterior
+    std::filesystem::remove(archivo_indice_usuarios, ec);
+    {
+        std::lock_guard<std::mutex> lock_indice(mtx_indice);
+        offsets_por_usuario.clear();
+        tramos_tiempo.clear();
+    }
+    fin_indexado = 0;
+    publicar_historial(0);
     
-    std::ifstream src1(archivo_usuarios, std::ios::binary);
-    std::ofstream dst1(backup_usuarios, std::ios::binary);
-    dst1 << src1.rdbuf();
+    std::cout << "[DB] " << archivados << " transacciones archivadas en " << ruta
+              << " (" << contenido_segmento.size() << " bytes)" << std::endl;
+    return archivados;
+}
+
+size_t DatabaseJSON::archivar_transacciones() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return archivar_sin_lock();
+}
+
+void DatabaseJSON::configurar_archivado(uint64_t umbral_bytes_log) {
+    std::lock_guard<std::mutex> lock(mtx);
+    umbral_archivado = umbral_bytes_log;
+}
+
+bool DatabaseJSON::guardar_usuario(const UsuarioDB& usuario, CommitPendiente* pendiente) {
+    std::unique_lock<std::mutex> lock(mtx);
+    
+    // Verificar si ya existe
+    if (indice_nombre.count(usuario.nombre)) {
+        return false; // Usuario ya existe
+    }
+    
+    // El alta es un append al log de usuarios; el snapshot la incorpora
+    // en el próximo checkpoint
+    RegistroSaldo registro;
+    registro.lsn = ultimo_lsn + 1;
+    registro.alta = true;
+    registro.usuario = usuario;
+    EscritorLog::Ticket ticket;
+    if (!agregar_al_log_usuarios(registro, ticket)) return false;
+    
+    ultimo_lsn = registro.lsn;
+    usuarios.push_back(usuario);
+    lsn_usuarios.push_back(registro.lsn);
+    indexar_usuario(usuarios.size() - 1);
+    publicar_usuarios({});
+    registrar_cambio_sin_checkpoint();
+    
+    return terminar_commit(lock, *escritor_usuarios, ticket, pendiente);
+}
+
+size_t DatabaseJSON::guardar_usuarios_lote(const std::vector<UsuarioDB>& lote) {
+    std::unique_lock<std::mutex> lock(mtx);
+    if (!escritor_usuarios) return 0;
+    
+    // Los nombres del lote se validan contra el índice y entre sí
+    std::unordered_set<std::string_view> nombres;
+    nombres.reserve(lote.size());
+    
+    // Lugar para todo el lote de una vez: sin rehash de los índices ni
+    // filtros rehechos varias veces a medida que crecen. El crecimiento
+    // sigue siendo geométrico ante muchos lotes chicos.
+    size_t total = usuarios.size() + lote.size();
+    if (total > usuarios.capacity()) {
+        size_t capacidad = std::max(total, 2 * usuarios.capacity());
+        usuarios.reserve(capacidad);
+        lsn_usuarios.reserve(capacidad);
+        indice_nombre.reserve(capacidad);
+        indice_cuenta.reserve(capacidad);
+    }
+    if (!filtro_nombres || filtro_nombres->capacidad() < total) rehacer_filtros(2 * total);
+    
+    // Las altas van al log en tandas de ~1 MiB (un agregar por tanda) y se
+    // aplican a la tabla cuando su tanda quedó escrita
+    const size_t tanda = 1024 * 1024;
+    std::vector<const UsuarioDB*> pendientes;
+    EscritorLog::Ticket ticket;
+    RegistroSaldo registro;
+    registro.alta = true;
+    size_t guardados = 0;
+    serializador.limpiar();
+    auto escribir_tanda = [&] {
+        if (pendientes.empty()) return true;
+        if (!escritor_usuarios->agregar(serializador.texto(), ticket)) return false;
+        for (const UsuarioDB* usuario : pendientes) {
+            usuarios.push_back(*usuario);
+            lsn_usuarios.push_back(++ultimo_lsn);
+            indexar_usuario(usuarios.size() - 1);
+            registrar_cambio_sin_checkpoint();
+        }
+        guardados += pendientes.size();
+        pendientes.clear();
+        serializador.limpiar();
+        return true;
+    };
+    
+    bool escrito = true;
+    for (const UsuarioDB& usuario : lote) {
+        if (indice_nombre.count(usuario.nombre) || !nombres.insert(usuario.nombre).second) {
+            continue;
+        }
+        registro.lsn = ultimo_lsn + 1 + pendientes.size();
+        registro.usuario = usuario;
+        serializar_saldo(registro, serializador);
+        pendientes.push_back(&usuario);
+        if (serializador.size() >= tanda && !(escrito = escribir_tanda())) break;
+    }
+    if (escrito) escribir_tanda();
+    
+    // Una sola versión publicada para todo el lote
+    if (guardados > 0) publicar_usuarios({});
+    
+    // Lo aplicado ya es visible y publicado: se cuenta aunque falle la
+    // sincronización, que queda avisada
+    lock.unlock();
+    if (guardados > 0 && !escritor_usuarios->esperar_durable(ticket)) {
+        std::cerr << "[DB] El lote se aplicó pero no se pudo sincronizar el log" << std::endl;
+    }
+    return guardados;
+}
+
+bool DatabaseJSON::actualizar_saldo(const std::string& nombre, double nuevo_saldo,
+                                    CommitPendiente* pendiente) {
+    std::unique_lock<std::mutex> lock(mtx);
+    
+    auto it = indice_nombre.find(nombre);
+    if (it == indice_nombre.end()) return false;
+    
+    if (intervalo_volcado.count() > 0) {
+        // Escritura diferida: los lectores ven el saldo ya; el delta se
+        // escribe en el próximo volcado, uno solo por usuario
+        usuarios[it->second].saldo = nuevo_saldo;
+        publicar_usuarios({it->second});
+        if (saldos_sucios.empty()) primer_sucio = std::chrono::steady_clock::now();
+        saldos_sucios.insert(it->second);
+        if (saldos_sucios.size() == umbral_volcado || saldos_sucios.size() == 1) {
+            cv_checkpoint.notify_one();
+        }
+        return true;
+    }
+    
+    // Un delta pequeño en lugar de reescribir usuarios.json completo
+    RegistroSaldo registro;
+    registro.lsn = ultimo_lsn + 1;
+    registro.usuario.nombre = nombre;
+    registro.usuario.saldo = nuevo_saldo;
+    EscritorLog::Ticket ticket;
+    if (!agregar_al_log_usuarios(registro, ticket)) return false;
+    
+    ultimo_lsn = registro.lsn;
+    usuarios[it->second].saldo = nuevo_saldo;
+    lsn_usuarios[it->second] = registro.lsn;
+    publicar_usuarios({it->second});
+    registrar_cambio_sin_checkpoint();
+    
+    return terminar_commit(lock, *escritor_usuarios, ticket, pendiente);
+}
+
+bool DatabaseJSON::commit_transferencia(const std::string& origen, const std::string& destino,
+                                        double monto, const TransaccionDB& transaccion,
+                                        CommitPendiente* pendiente) {
+    std::unique_lock<std::mutex> lock(mtx);
+    
+    auto it_origen = indice_nombre.find(origen);
+    auto it_destino = indice_nombre.find(destino);
+    if (it_origen == indice_nombre.end() || it_destino == indice_nombre.end()) return false;
+    if (it_origen->second == it_destino->second) return false;
+    
+    UsuarioDB& usuario_origen = usuarios[it_origen->second];
+    UsuarioDB& usuario_destino = usuarios[it_destino->second];
+    if (usuario_origen.saldo < monto) return false;
+    
+    // Un único registro lleva la transacción y los dos saldos resultantes:
+    // o se escribe completo o, al recuperar, no se aplica nada
+    RegistroLog registro;
+    registro.lsn = ultimo_lsn + 1;
+    registro.transaccion = transaccion;
+    registro.transaccion.usuario_origen = origen;
+    registro.transaccion.usuario_destino = destino;
+    registro.transaccion.monto = monto;
+    registro.con_saldos = true;
+    registro.saldo_origen = usuario_origen.saldo - monto;
+    registro.saldo_destino = usuario_destino.saldo + monto;
+    
+    EscritorLog::Ticket ticket;
+    if (!agregar_al_log(registro, ticket)) return false;
+    
+    ultimo_lsn = registro.lsn;
+    usuario_origen.saldo = registro.saldo_origen;
+    usuario_destino.saldo = registro.saldo_destino;
+    lsn_usuarios[it_origen->second] = registro.lsn;
+    lsn_usuarios[it_destino->second] = registro.lsn;
+    publicar_usuarios({it_origen->second, it_destino->second});
+    // El registro lleva los saldos completos: cubre lo que estuviera diferido
+    saldos_sucios.erase(it_origen->second);
+    saldos_sucios.erase(it_destino->second);
+    registrar_cambio_sin_checkpoint();
+    
+    // Esperar la durabilidad sin bloquear a los demás committers
+    return terminar_commit(lock, *escritor_log, ticket, pendiente);
+}
+
+void DatabaseJSON::indexar_usuario(size_t posicion) {
+    const UsuarioDB& u = usuarios[posicion];
+    indice_nombre.emplace(u.nombre, posicion);
+    // Ante cuentas repetidas gana la primera, igual que el recorrido lineal
+    indice_cuenta.emplace(u.cuenta_id, posicion);
+    
+    if (!filtro_nombres || filtro_nombres->lleno() || filtro_cuentas->lleno()) {
+        // Ya con este usuario en los índices
+        rehacer_filtros(2 * usuarios.size());
+        return;
+    }
+    filtro_nombres->agregar(u.nombre);
+    filtro_cuentas->agregar(u.cuenta_id);
+}
+
+void DatabaseJSON::rehacer_filtros(size_t capacidad) {
+    // Se rehacen desde los índices; las versiones publicadas conservan los
+    // anteriores, que siguen siendo válidos
+    capacidad = std::max<size_t>(1024, capacidad);
+    filtro_nombres = std::make_shared<FiltroBloom>(capacidad);
+    filtro_cuentas = std::make_shared<FiltroBloom>(capacidad);
+    for (const auto& entrada : indice_nombre) filtro_nombres->agregar(entrada.first);
+    for (const auto& entrada : indice_cuenta) filtro_cuentas->agregar(entrada.first);
+}
+
+void DatabaseJSON::publicar_usuarios(std::initializer_list<size_t> cambiados) {
+    const size_t tam_pagina = VersionUsuarios::TAM_PAGINA;
+    auto copiar_pagina = [&](size_t pagina) {
+        auto desde = usuarios.begin() + pagina * tam_pagina;
+        auto hasta = usuarios.begin() + std::min(usuarios.size(), (pagina + 1) * tam_pagina);
+        return std::make_shared<const std::vector<UsuarioDB>>(desde, hasta);
+    };
+    
+    // La versión nueva comparte las páginas y los índices que no cambian
+    std::shared_ptr<const VersionUsuarios> actual = std::atomic_load(&usuarios_publicados);
+    auto nueva = std::make_shared<VersionUsuarios>(*actual);
+    nueva->version = actual->version + 1;
+    
+    if (usuarios.size() != actual->cantidad) {
+        // Altas: van a los índices de altas recientes, que se copian. Cuando
+        // pasan de ~raíz cuadrada de la tabla se funden con los completos (una
+        // copia de todo cada tantas altas), así cada alta copia O(raíz de n).
+        // Las páginas se rehacen desde la primera que crece.
+        using Indice = VersionUsuarios::Indice;
+        size_t desde = std::min(actual->cantidad, usuarios.size());
+        size_t recientes = actual->recientes_nombre->size() + (usuarios.size() - desde);
+        size_t raiz = static_cast<size_t>(std::sqrt(static_cast<double>(usuarios.size())));
+        size_t limite = std::max<size_t>(256, raiz);
+        if (recientes > limite || actual->cantidad > usuarios.size()) {
+            nueva->indice_nombre = std::make_shared<const Indice>(indice_nombre);
+            nueva->indice_cuenta = std::make_shared<const Indice>(indice_cuenta);
+            nueva->recientes_nombre = std::make_shared<const Indice>();
+            nueva->recientes_cuenta = std::make_shared<const Indice>();
+        } else {
+            auto nombres = std::make_shared<Indice>(*actual->recientes_nombre);
+            auto cuentas = std::make_shared<Indice>(*actual->recientes_cuenta);
+            for (size_t i = desde; i < usuarios.size(); ++i) {
+                nombres->emplace(usuarios[i].nombre, i);
+                // Ante cuentas repetidas gana la primera, como en indexar_usuario
+                if (!actual->indice_cuenta->count(usuarios[i].cuenta_id)) {
+                    cuentas->emplace(usuarios[i].cuenta_id, i);
+                }
+            }
+            nueva->recientes_nombre = std::move(nombres);
+            nueva->recientes_cuenta = std::move(cuentas);
+        }
+        nueva->filtro_nombres = filtro_nombres;
+        nueva->filtro_cuentas = filtro_cuentas;
+        size_t primera = desde / tam_pagina;
+        nueva->paginas.resize(primera);
+        for (size_t p = primera; p * tam_pagina < usuarios.size(); ++p) {
+            nueva->paginas.push_back(copiar_pagina(p));
+        }
+        nueva->cantidad = usuarios.size();
+    }
+    for (size_t posicion : cambiados) {
+        nueva->paginas[posicion / tam_pagina] = copiar_pagina(posicion / tam_pagina);
+    }
+    
+    std::atomic_store(&usuarios_publicados, std::shared_ptr<const VersionUsuarios>(std::move(nueva)));
+    version_datos++;
+}
+
+bool DatabaseJSON::escribir_usuarios() {
+    SerializadorJSON archivo;
+    archivo.literal("[\n");
+    for (size_t i = 0; i < usuarios.size(); ++i) {
+        archivo.literal("  {\n    \"nombre\": ");
+        archivo.cadena(usuarios[i].nombre);
+        archivo.literal(",\n    \"cuenta_id\": ");
+        archivo.cadena(usuarios[i].cuenta_id);
+        archivo.literal(",\n    \"saldo\": ");
+        archivo.monto(usuarios[i].saldo);
+        archivo.literal(",\n    \"fecha_creacion\": ");
+        archivo.cadena(usuarios[i].fecha_creacion);
+        archivo.literal(",\n    \"lsn\": ");
+        archivo.natural(lsn_usuarios[i]);
+        archivo.literal(i < usuarios.size() - 1 ? "\n  },\n" : "\n  }\n");
+    }
+    archivo.literal("]\n");
+    
+    // El snapshot se reemplaza completo o no se toca
+    return io_archivos::reemplazar_archivo(archivo_usuarios, archivo.texto());
+}
+
+std::vector<UsuarioDB> DatabaseJSON::cargar_usuarios() {
+    return version_usuarios()->a_vector();
+}
+
+std::shared_ptr<const VersionUsuarios> DatabaseJSON::version_usuarios() const {
+    return std::atomic_load(&usuarios_publicados);
+}
+
+std::vector<UsuarioDB> DatabaseJSON::cargar_usuarios_archivo(std::vector<uint64_t>& lsns) {
+    std::vector<UsuarioDB> leidos;
+    lsns.clear();
+    
+    std::string buffer;
+    if (!leer_archivo_completo(archivo_usuarios, buffer)) return leidos;
+    
+    if (!parsear_usuarios_json(buffer, leidos, &lsns)) {
+        std::cerr << "[DB] " << archivo_usuarios << " mal formado; se cargaron "
+                  << leidos.size() << " usuarios" << std::endl;
+    }
+    return leidos;
+}
+
+bool DatabaseJSON::parsear_usuarios_json(std::string_view texto, std::vector<UsuarioDB>& destino,
+                                         std::vector<uint64_t>* lsns) {
+    LectorJSON lector(texto);
+    if (lector.al_final()) return true;
+    
+    UsuarioDB actual{"", "", 0.0, ""};
+    uint64_t lsn = 0;
+    bool leido = lector.recorrer_arreglo(
+        [&](std::string_view clave, const ValorJSON& valor) {
+            if (clave == "lsn") {
+                valor.como_entero(lsn);
+            } else {
+                asignar_campo_usuario(clave, valor, actual);
+            }
+        },
+        [&]() {
+            destino.push_back(std::move(actual));
+            if (lsns) lsns->push_back(lsn);
+            actual = UsuarioDB{"", "", 0.0, ""};
+            lsn = 0;
+        });
+    return leido && lector.al_final();
+}
+
+bool DatabaseJSON::parsear_transacciones_json(std::string_view texto,
+                                              std::vector<TransaccionDB>& destino) {
+    LectorJSON lector(texto);
+    if (lector.al_final()) return true;
+    
+    TransaccionDB actual{0, "", "", 0.0, "", false, ""};
+    bool leido = lector.recorrer_arreglo(
+        [&](std::string_view clave, const ValorJSON& valor) {
+            asignar_campo_transaccion(clave, valor, actual);
+        },
+        [&]() {
+            destino.push_back(std::move(actual));
+            actual = TransaccionDB{0, "", "", 0.0, "", false, ""};
+        });
+    return leido && lector.al_final();
+}
+
+UsuarioDB DatabaseJSON::obtener_usuario(const std::string& nombre) {
+    auto version = version_usuarios();
+    
+    const UsuarioDB* usuario = version->buscar_nombre(nombre);
+    if (usuario) {
+        return *usuario;
+    }
+    return UsuarioDB{"", "", -1.0, ""};
+}
+
+
+UsuarioDB DatabaseJSON::obtener_usuario_por_cuenta(const std::string& cuenta_id) {
+    auto version = version_usuarios();
+
+    const UsuarioDB* usuario = version->buscar_cuenta(cuenta_id);
+    if (usuario) {
+        return *usuario;
+    }
+
+    // Usuario no encontrado
+    return UsuarioDB{"", "", -1.0, ""};
+}
+
+bool DatabaseJSON::usuario_existe(const std::string& nombre) {
+    return version_usuarios()->buscar_nombre(nombre) != nullptr;
+}
+
+bool DatabaseJSON::commit_movimiento(const std::string& local, double delta,
+                                     const TransaccionDB& transaccion, CommitPendiente* pendiente) {
+    return escribir_movimiento(local, delta, transaccion, true, pendiente);
+}
+
+bool DatabaseJSON::completar_movimiento(const std::string& local, double delta,
+                                        const TransaccionDB& transaccion) {
+    return escribir_movimiento(local, delta, transaccion, false, nullptr);
+}
+
+bool DatabaseJSON::escribir_movimiento(const std::string& local, double delta,
+                                       const TransaccionDB& transaccion, bool validar_saldo,
+                                       CommitPendiente* pendiente) {
+    std::unique_lock<std::mutex> lock(mtx);
+    
+    auto it = indice_nombre.find(local);
+    if (it == indice_nombre.end()) return false;
+    bool es_origen = (transaccion.usuario_origen == local);
+    if (!es_origen && transaccion.usuario_destino != local) return false;
+    
+    UsuarioDB& usuario = usuarios[it->second];
+    if (validar_saldo && usuario.saldo + delta < 0.0) return false;
+    
+    // El saldo del otro usuario no se conoce aquí; al recuperar se ignora
+    // porque ese usuario no existe en esta base
+    RegistroLog registro;
+    registro.lsn = ultimo_lsn + 1;
+    registro.transaccion = transaccion;
+    registro.con_saldos = true;
+    (es_origen ? registro.saldo_origen : registro.saldo_destino) = usuario.saldo + delta;
+    
+    EscritorLog::Ticket ticket;
+    if (!agregar_al_log(registro, ticket)) return false;
+    
+    ultimo_lsn = registro.lsn;
+    usuario.saldo += delta;
+    lsn_usuarios[it->second] = registro.lsn;
+    publicar_usuarios({it->second});
+    saldos_sucios.erase(it->second);
+    registrar_cambio_sin_checkpoint();
+    
+    return terminar_commit(lock, *escritor_log, ticket, pendiente);
+}
+
+bool DatabaseJSON::guardar_transaccion(const TransaccionDB& transaccion, CommitPendiente* pendiente) {
+    std::unique_lock<std::mutex> lock(mtx);
+    
+    // Un commit es un único append al log, sin releer el historial
+    RegistroLog registro;
+    registro.lsn = ultimo_lsn + 1;
+    registro.transaccion = transaccion;
+    EscritorLog::Ticket ticket;
+    if (!agregar_al_log(registro, ticket)) return false;
+    
+    ultimo_lsn = registro.lsn;
+    
+    return terminar_commit(lock, *escritor_log, ticket, pendiente);
+}
+
+bool DatabaseJSON::terminar_commit(std::unique_lock<std::mutex>& lock, EscritorLog& escritor,
+                                   const EscritorLog::Ticket& ticket, CommitPendiente* pendiente) {
+    lock.unlock();
+    if (pendiente) {
+        pendiente->escritor = &escritor;
+        pendiente->ticket = ticket;
+        return true;
+    }
+    return escritor.esperar_durable(ticket);
+}
+
+bool DatabaseJSON::esperar_commit(const CommitPendiente& pendiente) {
+    return !pendiente.escritor || pendiente.escritor->esperar_durable(pendiente.ticket);
+}
+
+size_t DatabaseJSON::guardar_transacciones_lote(const std::vector<TransaccionDB>& lote) {
+    std::unique_lock<std::mutex> lock(mtx);
+    if (!escritor_log) return 0;
+    
+    // Ids del lote, en orden y sobre la secuencia: una fila con id 0 toma el
+    // siguiente, y una con id propio solo entra si es mayor que todo lo ya
+    // entregado (0: la fila se salta). El techo se persiste antes de escribir,
+    // como en reservar_ids, así el mayor id del lote sobrevive a un reinicio.
+    std::vector<int> ids(lote.size(), 0);
+    {
+        std::lock_guard<std::mutex> lock_ids(mtx_ids);
+        int siguiente = siguiente_id;
+        for (size_t i = 0; i < lote.size(); ++i) {
+            int id = (lote[i].id == 0) ? siguiente : lote[i].id;
+            if (id < siguiente || id == INT_MAX) continue;
+            ids[i] = id;
+            siguiente = id + 1;
+        }
+        if (siguiente - 1 > techo_ids) {
+            int nuevo_techo = siguiente - 1 + TAM_BLOQUE_IDS;
+            if (!persistir_techo_ids(nuevo_techo)) {
+                std::cerr << "[DB] No se pudo persistir la secuencia de ids" << std::endl;
+                return 0;
+            }
+            techo_ids = nuevo_techo;
+        }
+        siguiente_id = siguiente;
+    }
+    
+    // Tandas de ~1 MiB: un agregar al log y una escritura al .idx por tanda.
+    // Cada pendiente guarda su offset dentro de la tanda.
+    const size_t tanda = 1024 * 1024;
+    std::vector<std::pair<const TransaccionDB*, uint64_t>> pendientes;
+    std::string lineas_indice;
+    EscritorLog::Ticket ticket;
+    RegistroLog registro;
+    size_t guardadas = 0;
+    serializador.limpiar();
+    auto escribir_tanda = [&] {
+        if (pendientes.empty()) return true;
+        if (!escritor_log->agregar(serializador.texto(), ticket)) return false;
+        version_datos++;
+        cambios_historial++;
+        
+        lineas_indice.clear();
+        for (const auto& [transaccion, relativo] : pendientes) {
+            int64_t segundos = segundos_de(transaccion->fecha);
+            indexar_registro(tam_log + relativo, *transaccion, segundos, false);
+            agregar_linea_indice(lineas_indice, tam_log + relativo, *transaccion, segundos);
+        }
+        escribir_lineas_indice(lineas_indice);
+        
+        tam_log += serializador.size();
+        ultimo_lsn += pendientes.size();
+        guardadas += pendientes.size();
+        pendientes.clear();
+        serializador.limpiar();
+        return true;
+    };
+    
+    bool escrito = true;
+    for (size_t i = 0; i < lote.size(); ++i) {
+        if (ids[i] == 0) continue;
+        registro.lsn = ultimo_lsn + 1 + pendientes.size();
+        registro.transaccion = lote[i];
+        registro.transaccion.id = ids[i];
+        pendientes.emplace_back(&lote[i], serializador.size());
+        serializar_registro(registro, serializador);
+        if (serializador.size() >= tanda && !(escrito = escribir_tanda())) break;
+    }
+    if (escrito) escribir_tanda();
+    
+    // Lo aplicado ya es visible y publicado: se cuenta aunque falle la
+    // sincronización, que queda avisada
+    lock.unlock();
+    if (guardadas > 0 && !escritor_log->esperar_durable(ticket)) {
+        std::cerr << "[DB] El lote se aplicó pero no se pudo sincronizar el log" << std::endl;
+    }
+    return guardadas;
+}
+
+std::vector<TransaccionDB> DatabaseJSON::cargar_transacciones(int limite) {
+    return leer_con_cache("", limite, [&] {
+        return mapear_transacciones(limite).a_transacciones(limite > 0 ? 1 : hilos_de_carga());
+    });
+}
+
+std::vector<TransaccionDB> DatabaseJSON::leer_con_cache(const std::string& consulta, int limite,
+                                                        const std::function<std::vector<TransaccionDB>()>& leer) {
+    // La versión se toma antes de leer: si una escritura llega durante la
+    // lectura, la entrada queda con la versión anterior y no se vuelve a usar
+    uint64_t version = version_datos.load();
+    auto clave = std::make_pair(consulta, limite);
+    std::shared_ptr<const std::vector<TransaccionDB>> guardadas;
+    {
+        std::lock_guard<std::mutex> lock(mtx_cache);
+        if (capacidad_cache == 0 || limite <= 0 || limite > LIMITE_CACHE) return leer();
+        auto it = cache_lecturas.find(clave);
+        if (it != cache_lecturas.end() && it->second.version == version) {
+            aciertos_cache++;
+            guardadas = it->second.transacciones;
+        } else {
+            fallos_cache++;
+        }
+    }
+    if (guardadas) return *guardadas;
+    
+    auto leidas = std::make_shared<const std::vector<TransaccionDB>>(leer());
+    std::lock_guard<std::mutex> lock(mtx_cache);
+    if (version_datos.load() == version) {
+        // Las entradas de versiones anteriores ya no se van a usar
+        for (auto it = cache_lecturas.begin(); it != cache_lecturas.end();) {
+            if (it->second.version != version) it = cache_lecturas.erase(it);
+            else ++it;
+        }
+        if (cache_lecturas.size() >= capacidad_cache) cache_lecturas.erase(cache_lecturas.begin());
+        cache_lecturas[clave] = EntradaCache{version, leidas};
+    }
+    return *leidas;
+}
+
+void DatabaseJSON::configurar_cache(size_t entradas) {
+    std::lock_guard<std::mutex> lock(mtx_cache);
+    capacidad_cache = entradas;
+    cache_lecturas.clear();
+}
+
+EstadisticasCache DatabaseJSON::obtener_estadisticas_cache() {
+    std::lock_guard<std::mutex> lock(mtx_cache);
+    return EstadisticasCache{aciertos_cache, fallos_cache, cache_lecturas.size()};
+}
+
+uint64_t DatabaseJSON::obtener_version_datos() const {
+    return version_datos.load();
+}
+
+size_t DatabaseJSON::hilos_de_carga() const {
+    // Sin el mutex: un checkpoint o un archivado no frenan a los lectores
+    size_t hilos = hilos_carga.load(std::memory_order_relaxed);
+    if (hilos > 0) return hilos;
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void DatabaseJSON::configurar_hilos_carga(size_t hilos) {
+    hilos_carga.store(hilos, std::memory_order_relaxed);
+}
+
+std::shared_ptr<const ArchivoMapeado> DatabaseJSON::mapear_log() {
+    // Lo aceptado y aún en el lote del group commit también debe verse
+    if (escritor_log) escritor_log->escribir_pendientes();
+    return std::make_shared<const ArchivoMapeado>(archivo_log_transacciones);
+}
+
+void DatabaseJSON::publicar_historial(uint64_t inicio_log) {
+    auto version = std::make_shared<VersionHistorial>();
+    version->segmentos = segmentos;
+    version->escritor = escritor_log;
+    version->inicio_log = inicio_log;
+    std::atomic_store(&historial_publicado, std::shared_ptr<const VersionHistorial>(std::move(version)));
+}
+
+void DatabaseJSON::tomar_historial(SegmentosArchivo& archivados, std::shared_ptr<const ArchivoMapeado>& log,
+                                   size_t& inicio_log, const std::function<void()>& durante) {
+    // Sin el lock: se mapea el log y se comprueba que la versión publicada no
+    // cambió mientras tanto. Si cambió (archivado de por medio), el mapeo
+    // puede ser del log nuevo con los segmentos viejos y se repite.
+    while (true) {
+        std::shared_ptr<const VersionHistorial> version = std::atomic_load(&historial_publicado);
+        // Lo aceptado y aún en el lote del group commit también debe verse
+        if (version->escritor) version->escritor->escribir_pendientes();
+        log = std::make_shared<const ArchivoMapeado>(archivo_log_transacciones);
+        if (durante) durante();
+        if (std::atomic_load(&historial_publicado) != version) continue;
+        
+        archivados = version->segmentos;
+        inicio_log = std::min<size_t>(version->inicio_log, log->contenido().size());
+        return;
+    }
+}
+
+HistorialMapeado DatabaseJSON::leer_historial(SegmentosArchivo segmentos,
+                                              std::shared_ptr<const ArchivoMapeado> log, size_t inicio_log,
+                                              size_t limite, size_t hilos) {
+    HistorialMapeado historial;
+    historial.archivo = std::move(log);
+    historial.segmentos = std::move(segmentos);
+    // Lo anterior a 'inicio_log' ya está en los segmentos
+    std::string_view contenido = historial.archivo->contenido().substr(inicio_log);
+    std::vector<TransaccionVista>& registros = historial.registros;
+    TransaccionVista vista;
+    std::string_view json;
+    
+    if (limite == 0) {
+        // Los segmentos se decodifican a la vez, uno por hilo; sus bloques
+        // quedan en el historial mientras se usen las vistas
+        const SegmentosArchivo& archivados = historial.segmentos;
+        size_t partes = std::min(hilos, archivados.size());
+        std::vector<std::vector<TransaccionVista>> por_segmento(archivados.size());
+        std::vector<BloquesDecodificados> bloques(archivados.size());
+        ejecutar_en_paralelo(partes, [&](size_t parte) {
+            for (size_t i = parte; i < archivados.size(); i += partes) {
+                archivados[i]->vistas_filas(0, archivados[i]->size(), por_segmento[i], bloques[i]);
+            }
+        });
+        for (size_t i = 0; i < archivados.size(); ++i) {
+            registros.insert(registros.end(), por_segmento[i].begin(), por_segmento[i].end());
+            historial.bloques.insert(historial.bloques.end(), bloques[i].begin(), bloques[i].end());
+        }
+        
+        // El log se corta en tramos de bytes; cada corte se corre hasta el
+        // siguiente '\n' (ningún registro lleva saltos de línea sin escapar),
+        // así cada tramo empieza en un registro. Los tramos se parsean en
+        // paralelo y se unen en el orden del archivo.
+        partes = partes_para(contenido.size(), 4 * 1024 * 1024, hilos);
+        std::vector<size_t> cortes(partes + 1, contenido.size());
+        cortes[0] = 0;
+        for (size_t i = 1; i < partes; ++i) {
+            size_t posicion = std::max(contenido.size() * i / partes, cortes[i - 1] + 1);
+            size_t salto = contenido.find('\n', posicion - 1);
+            cortes[i] = (salto == std::string_view::npos) ? contenido.size() : salto + 1;
+        }
+        
+        std::vector<std::vector<TransaccionVista>> tramos(partes);
+        ejecutar_en_paralelo(partes, [&](size_t parte) {
+            TransaccionVista vista_tramo;
+            std::string_view json_tramo;
+            std::string_view tramo = contenido.substr(cortes[parte], cortes[parte + 1] - cortes[parte]);
+            recorrer_lineas(tramo, [&](std::string_view linea, size_t) {
+                if (desenmarcar_registro(linea, json_tramo) && parsear_vista(json_tramo, vista_tramo)) {
+                    tramos[parte].push_back(vista_tramo);
+                }
+            });
+        });
+        
+        size_t total = registros.size();
+        for (const auto& tramo : tramos) total += tramo.size();
+        registros.reserve(total);
+        for (const auto& tramo : tramos) {
+            registros.insert(registros.end(), tramo.begin(), tramo.end());
+        }
+        return historial;
+    }
+    
+    // Con límite se recorre el mapeo hacia atrás y solo se decodifica la cola
+    const size_t npos = std::string_view::npos;
+    size_t fin = contenido.rfind('\n');
+    while (fin != npos && registros.size() < limite) {
+        size_t inicio = (fin == 0) ? npos : contenido.rfind('\n', fin - 1);
+        inicio = (inicio == npos) ? 0 : inicio + 1;
+        if (desenmarcar_registro(contenido.substr(inicio, fin - inicio), json) &&
+            parsear_vista(json, vista)) {
+            registros.push_back(vista);
+        }
+        fin = (inicio == 0) ? npos : inicio - 1;
+    }
+    // Si el log no alcanza, el resto sale de la cola de los segmentos: solo
+    // se descomprimen sus últimos bloques
+    std::vector<TransaccionVista> cola;
+    for (auto it = historial.segmentos.rbegin();
+         it != historial.segmentos.rend() && registros.size() < limite; ++it) {
+        const SegmentoColumnar& segmento = **it;
+        size_t faltan = limite - registros.size();
+        size_t desde = (segmento.size() > faltan) ? segmento.size() - faltan : 0;
+        cola.clear();
+        if (!segmento.vistas_filas(desde, segmento.size(), cola, historial.bloques)) continue;
+        registros.insert(registros.end(), cola.rbegin(), cola.rend());
+    }
+    std::reverse(registros.begin(), registros.end());
+    return historial;
+}
+
+HistorialMapeado DatabaseJSON::mapear_transacciones(int limite) {
+    std::shared_ptr<const ArchivoMapeado> log;
+    SegmentosArchivo archivados;
+    size_t inicio_log = 0;
+    tomar_historial(archivados, log, inicio_log);
+    // El mapeo fija el largo del log: el parseo no necesita el lock
+    return leer_historial(std::move(archivados), std::move(log), inicio_log,
+                          limite > 0 ? static_cast<size_t>(limite) : 0, hilos_de_carga());
+}
+
+std::vector<TransaccionDB> DatabaseJSON::cargar_transacciones_legado() {
+    std::vector<TransaccionDB> transacciones;
+    
+    std::string buffer;
+    if (!leer_archivo_completo(archivo_transacciones, buffer)) return transacciones;
+    
+    if (!parsear_transacciones_json(buffer, transacciones)) {
+        std::cerr << "[DB] " << archivo_transacciones << " mal formado; se migraron "
+                  << transacciones.size() << " transacciones" << std::endl;
+    }
+    return transacciones;
+}
+
+RangoTransacciones DatabaseJSON::recorrer_transacciones() {
+    RangoTransacciones rango;
+    tomar_historial(rango.segmentos, rango.archivo, rango.inicio_log);
+    return rango;
+}
+
+size_t DatabaseJSON::for_each_transaccion(const std::function<bool(const TransaccionVista&)>& predicado,
+                                          const std::function<bool(const TransaccionVista&)>& visitar) {
+    size_t visitados = 0;
+    for (const auto& t : recorrer_transacciones()) {
+        if (predicado && !predicado(t)) continue;
+        visitados++;
+        if (!visitar(t)) break;
+    }
+    return visitados;
+}
+
+size_t DatabaseJSON::consultar_transacciones(const ConsultaTransacciones& consulta,
+                                             const std::function<bool(const TransaccionVista&)>& visitar) {
+    FiltroLog filtro(consulta);
+    // Con un usuario, el log se lee solo en sus offsets; con un período,
+    // solo en los tramos que pueden tenerlo (como en los mapear_*)
+    const std::string* nombre = !consulta.origen.empty() ? &consulta.origen
+                              : !consulta.destino.empty() ? &consulta.destino
+                              : !consulta.usuario.empty() ? &consulta.usuario : nullptr;
+    SegmentosArchivo archivados;
+    std::shared_ptr<const ArchivoMapeado> log;
+    size_t inicio_log = 0;
+    std::vector<uint64_t> offsets;
+    std::vector<TramoTiempo> tramos;
+    tomar_historial(archivados, log, inicio_log, [&] {
+        std::lock_guard<std::mutex> lock_indice(mtx_indice);
+        if (nombre) {
+            auto it = offsets_por_usuario.find(*nombre);
+            if (it == offsets_por_usuario.end()) offsets.clear();
+            else offsets = it->second;
+        } else if (filtro.con_periodo) {
+            auto primero = std::partition_point(tramos_tiempo.begin(), tramos_tiempo.end(),
+                                                [&](const TramoTiempo& tramo) {
+                                                    return tramo.maximo_acumulado < consulta.desde;
+                                                });
+            if (primero == tramos_tiempo.end() && primero != tramos_tiempo.begin()) --primero;
+            tramos.assign(primero, tramos_tiempo.end());
+        }
+    });
+    
+    size_t visitados = 0;
+    for (const auto& segmento : archivados) {
+        bool seguir = segmento->recorrer_consulta(consulta, [&](const TransaccionVista& vista) {
+            visitados++;
+            return visitar(vista);
+        });
+        if (!seguir) return visitados;
+    }
+    if (!log) return visitados;
+    
+    // Antes de parsear, un registro que no contiene las marcas del filtro se
+    // descarta sin calcular su CRC
+    std::string_view contenido = log->contenido();
+    TransaccionVista vista;
+    std::string_view json;
+    auto procesar = [&](std::string_view linea) {
+        if (!filtro.puede_cumplir(linea)) return true;
+        if (!desenmarcar_registro(linea, json) || !filtro.parsear(json, vista)) return true;
+        visitados++;
+        return visitar(vista);
+    };
+    auto recorrer_tramo = [&](uint64_t inicio, uint64_t fin) {
+        inicio = std::max<uint64_t>(inicio, inicio_log);
+        fin = std::min<uint64_t>(fin, contenido.size());
+        while (inicio < fin) {
+            size_t fin_linea = contenido.find('\n', inicio);
+            if (fin_linea == std::string_view::npos || fin_linea >= fin) break;
+            if (!procesar(contenido.substr(inicio, fin_linea - inicio))) return false;
+            inicio = fin_linea + 1;
+        }
+        return true;
+    };
+    
+    if (nombre) {
+        for (uint64_t offset : offsets) {
+            if (offset < inicio_log || offset >= contenido.size()) continue;
+            size_t fin = contenido.find('\n', offset);
+            if (fin == std::string_view::npos) continue;
+            if (!procesar(contenido.substr(offset, fin - offset))) break;
+        }
+    } else if (filtro.con_periodo && !tramos.empty()) {
+        // El último tramo se recorre siempre: puede tener registros
+        // escritos después de copiar el índice
+        for (size_t i = 0; i < tramos.size(); ++i) {
+            bool ultimo = (i + 1 == tramos.size());
+            if (!ultimo && (tramos[i].hasta < consulta.desde || tramos[i].desde > consulta.hasta)) continue;
+            if (!recorrer_tramo(tramos[i].offset, ultimo ? contenido.size() : tramos[i + 1].offset)) break;
+        }
+    } else {
+        recorrer_tramo(0, contenido.size());
+    }
+    return visitados;
+}
+
+ResumenTransacciones DatabaseJSON::resumir_transacciones(const ConsultaTransacciones& consulta) {
+    ResumenTransacciones resumen;
+    consultar_transacciones(consulta, [&](const TransaccionVista& t) {
+        if (resumen.cantidad == 0) {
+            resumen.monto_minimo = t.monto;
+            resumen.monto_maximo = t.monto;
+        } else {
+            resumen.monto_minimo = std::min(resumen.monto_minimo, t.monto);
+            resumen.monto_maximo = std::max(resumen.monto_maximo, t.monto);
+        }
+        resumen.cantidad++;
+        resumen.sospechosas += t.es_sospechosa ? 1 : 0;
+        resumen.suma_montos += t.monto;
+        return true;
+    });
+    return resumen;
+}
+
+std::vector<TransaccionDB> DatabaseJSON::cargar_transacciones_usuario(const std::string& nombre, int limite) {
+    // El nombre va después de un prefijo que no comparte con cargar_transacciones
+    return leer_con_cache("u" + nombre, limite, [&] {
+        return mapear_transacciones_usuario(nombre, limite).a_transacciones();
+    });
+}
+
+HistorialMapeado DatabaseJSON::mapear_transacciones_usuario(const std::string& nombre, int limite) {
+    HistorialMapeado historial;
+    std::vector<uint64_t> offsets;
+    size_t inicio_log = 0;
+    // Los offsets se copian con el log ya mapeado: los que caigan más allá
+    // de su final son de registros posteriores y se saltan
+    tomar_historial(historial.segmentos, historial.archivo, inicio_log, [&] {
+        std::lock_guard<std::mutex> lock_indice(mtx_indice);
+        auto it = offsets_por_usuario.find(nombre);
+        if (it == offsets_por_usuario.end()) offsets.clear();
+        else offsets = it->second;
+    });
+    
+    // Los offsets del prefijo ya archivado quedan fuera
+    offsets.erase(offsets.begin(), std::lower_bound(offsets.begin(), offsets.end(), inicio_log));
+    if (limite > 0 && offsets.size() > static_cast<size_t>(limite)) {
+        offsets.erase(offsets.begin(), offsets.end() - limite);
+    }
+    
+    // Lo que no alcance el log sale del historial archivado, del segmento más
+    // reciente hacia atrás. En un segmento el usuario se busca por su índice
+    // en el diccionario, sin decodificar los registros de los demás.
+    size_t faltan = (limite > 0) ? static_cast<size_t>(limite) - offsets.size() : SIZE_MAX;
+    std::string nombre_json = escapar_json(nombre);
+    std::vector<TransaccionVista> archivados;
+    std::vector<TransaccionVista> del_segmento;
+    for (auto it = historial.segmentos.rbegin(); it != historial.segmentos.rend() && faltan > 0; ++it) {
+        del_segmento.clear();
+        (*it)->vistas_de_usuario(nombre_json, faltan, del_segmento, historial.bloques);
+        archivados.insert(archivados.end(), del_segmento.rbegin(), del_segmento.rend());
+        faltan -= del_segmento.size();
+    }
+    historial.registros.assign(archivados.rbegin(), archivados.rend());
+    
+    // En el log solo se decodifican los registros del usuario, saltando a su offset
+    std::string_view contenido = historial.archivo->contenido();
+    TransaccionVista vista;
+    std::string_view json;
+    for (uint64_t offset : offsets) {
+        if (offset >= contenido.size()) continue;
+        size_t fin = contenido.find('\n', offset);
+        if (fin == std::string_view::npos) continue;
+        if (desenmarcar_registro(contenido.substr(offset, fin - offset), json) &&
+            parsear_vista(json, vista)) {
+            historial.registros.push_back(vista);
+        }
+    }
+    
+    return historial;
+}
+
+std::vector<TransaccionDB> DatabaseJSON::cargar_transacciones_rango(int id_desde, int id_hasta) {
+    return mapear_transacciones_rango(id_desde, id_hasta).a_transacciones();
+}
+
+HistorialMapeado DatabaseJSON::mapear_transacciones_rango(int id_desde, int id_hasta) {
+    HistorialMapeado historial;
+    size_t inicio_log = 0;
+    tomar_historial(historial.segmentos, historial.archivo, inicio_log);
+    
+    // De cada segmento solo se descomprimen los bloques cuyo rango de ids se
+    // cruza con el pedido
+    for (const auto& segmento : historial.segmentos) {
+        segmento->vistas_por_id(id_desde, id_hasta, historial.registros, historial.bloques);
+    }
+    
+    // El log (lo no archivado) se recorre entero
+    std::string_view contenido = historial.archivo->contenido().substr(inicio_log);
+    TransaccionVista vista;
+    std::string_view json;
+    recorrer_lineas(contenido, [&](std::string_view linea, size_t) {
+        if (desenmarcar_registro(linea, json) && parsear_vista(json, vista) &&
+            vista.id >= id_desde && vista.id <= id_hasta) {
+            historial.registros.push_back(vista);
+        }
+    });
+    return historial;
+}
+
+std::vector<TransaccionDB> DatabaseJSON::cargar_transacciones_periodo(const std::string& desde,
+                                                                      const std::string& hasta) {
+    int64_t segundos_desde = 0;
+    int64_t segundos_hasta = 0;
+    if (!marcas_tiempo::a_segundos(desde, segundos_desde) || !marcas_tiempo::a_segundos(hasta, segundos_hasta)) {
+        std::cerr << "[DB] Período inválido (se espera AAAA-MM-DD hh:mm:ss): "
+                  << desde << " - " << hasta << std::endl;
+        return {};
+    }
+    return mapear_transacciones_periodo(segundos_desde, segundos_hasta).a_transacciones();
+}
+
+HistorialMapeado DatabaseJSON::mapear_transacciones_periodo(int64_t desde, int64_t hasta) {
+    HistorialMapeado historial;
+    std::vector<TramoTiempo> tramos;
+    size_t inicio_log = 0;
+    // Los tramos anteriores al primero cuyo máximo acumulado alcanza 'desde'
+    // no pueden tener nada del período: se copian los siguientes. El último
+    // se conserva siempre (ver abajo).
+    tomar_historial(historial.segmentos, historial.archivo, inicio_log, [&] {
+        std::lock_guard<std::mutex> lock_indice(mtx_indice);
+        auto primero = std::partition_point(tramos_tiempo.begin(), tramos_tiempo.end(),
+                                            [desde](const TramoTiempo& tramo) {
+                                                return tramo.maximo_acumulado < desde;
+                                            });
+        if (primero == tramos_tiempo.end() && primero != tramos_tiempo.begin()) --primero;
+        tramos.assign(primero, tramos_tiempo.end());
+    });
+    if (desde > hasta) return historial;
+    
+    for (const auto& segmento : historial.segmentos) {
+        segmento->vistas_por_fecha(desde, hasta, historial.registros, historial.bloques);
+    }
+    
+    std::string_view contenido = historial.archivo->contenido();
+    TransaccionVista vista;
+    std::string_view json;
+    auto recorrer_tramo = [&](uint64_t inicio, uint64_t fin) {
+        inicio = std::max<uint64_t>(inicio, inicio_log);
+        fin = std::min<uint64_t>(fin, contenido.size());
+        if (inicio >= fin) return;
+        recorrer_lineas(contenido.substr(inicio, fin - inicio), [&](std::string_view linea, size_t) {
+            if (!desenmarcar_registro(linea, json) || !parsear_vista(json, vista)) return;
+            int64_t segundos = segundos_de(vista.fecha);
+            if (segundos != marcas_tiempo::SIN_FECHA && segundos >= desde && segundos <= hasta) {
+                historial.registros.push_back(vista);
+            }
+        });
+    };
+    
+    // El último tramo (o el log entero, sin tramos) se recorre siempre:
+    // puede tener registros escritos después de copiar el índice
+    if (tramos.empty()) recorrer_tramo(0, contenido.size());
+    for (size_t i = 0; i < tramos.size(); ++i) {
+        bool ultimo = (i + 1 == tramos.size());
+        if (!ultimo && (tramos[i].hasta < desde || tramos[i].desde > hasta)) continue;
+        recorrer_tramo(tramos[i].offset, ultimo ? contenido.size() : tramos[i + 1].offset);
+    }
+    return historial;
+}
+
+void DatabaseJSON::configurar_durabilidad(ModoDurabilidad modo) {
+    std::lock_guard<std::mutex> lock(mtx);
+    modo_durabilidad = modo;
+    if (escritor_log) escritor_log->cambiar_modo(modo);
+    if (escritor_usuarios) escritor_usuarios->cambiar_modo(modo);
+}
+
+ModoDurabilidad DatabaseJSON::obtener_durabilidad() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return modo_durabilidad;
+}
+
+EstadisticasCommit DatabaseJSON::obtener_estadisticas_commit(ModoDurabilidad modo) const {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!escritor_log) return EstadisticasCommit{modo, 0, 0, 0, 0, 0.0, 0.0, 0.0};
+    return escritor_log->estadisticas(modo);
+}
+
+void DatabaseJSON::reiniciar_estadisticas_commit() {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (escritor_log) escritor_log->reiniciar_estadisticas();
+}
+
+bool DatabaseJSON::sincronizar_log() {
+    std::lock_guard<std::mutex> lock(mtx);
+    // Los saldos diferidos también pasan a ser durables
+    EscritorLog::Ticket ticket;
+    size_t volcados = 0;
+    return escritor_log && escritor_usuarios && volcar_saldos_sin_lock(ticket, volcados) &&
+           escritor_log->sincronizar() && escritor_usuarios->sincronizar();
+}
+
+int DatabaseJSON::obtener_siguiente_id_transaccion() {
+    return reservar_ids(1);
+}
+
+int DatabaseJSON::consultar_siguiente_id() const {
+    std::lock_guard<std::mutex> lock(mtx_ids);
+    return siguiente_id;
+}
+
+int DatabaseJSON::reservar_ids(int cantidad) {
+    if (cantidad < 1) cantidad = 1;
+    std::lock_guard<std::mutex> lock(mtx_ids);
+    
+    int primero = siguiente_id;
+    // Antes de entregar ids por encima del techo persistido se amplía el techo,
+    // así un reinicio nunca vuelve a repartir un id ya entregado
+    if (primero + cantidad - 1 > techo_ids) {
+        int nuevo_techo = primero + cantidad - 1 + TAM_BLOQUE_IDS;
+        if (!persistir_techo_ids(nuevo_techo)) {
+            // Sin techo durable no se entrega nada: tras un reinicio se repetirían
+            std::cerr << "[DB] No se pudo persistir la secuencia de ids" << std::endl;
+            return -1;
+        }
+        techo_ids = nuevo_techo;
+    }
+    siguiente_id = primero + cantidad;
+    
+    return primero;
+}
+
+bool DatabaseJSON::avanzar_secuencia_ids(int id_usado) {
+    // Ids elegidos por el llamador también cuentan, para no repetirlos
+    std::lock_guard<std::mutex> lock(mtx_ids);
+    if (id_usado > techo_ids) {
+        int nuevo_techo = id_usado > std::numeric_limits<int>::max() - TAM_BLOQUE_IDS
+                              ? std::numeric_limits<int>::max() : id_usado + TAM_BLOQUE_IDS;
+        if (!persistir_techo_ids(nuevo_techo)) {
+            std::cerr << "[DB] No se pudo persistir la secuencia de ids" << std::endl;
+            return false;
+        }
+        techo_ids = nuevo_techo;
+    }
+    if (id_usado >= siguiente_id) {
+        siguiente_id = id_usado + 1;
+    }
+    return true;
+}
+
+bool DatabaseJSON::persistir_techo_ids(int techo) {
+    // El techo tiene que ser durable antes de repartir ids por debajo de él
+    return io_archivos::reemplazar_archivo(archivo_secuencia_ids, std::to_string(techo) + "\n");
+}
+
+void DatabaseJSON::recuperar_secuencia_ids() {
+    std::lock_guard<std::mutex> lock(mtx_ids);
+    
+    // De los segmentos alcanza con la cabecera
+    int max_id = 0;
+    for (const auto& segmento : segmentos) {
+        max_id = std::max(max_id, segmento->id_maximo());
+    }
+    
+    std::ifstream archivo(archivo_secuencia_ids);
+    bool recorrer_todo = true;
+    if (archivo >> techo_ids) {
+        // Con techo persistido basta con mirar la cola del log. Un id de la
+        // cola que lo alcanza viene de un log sin esa garantía (versiones
+        // anteriores): entonces se recorre completo.
+        int max_cola = 0;
+        for (const auto& t : leer_historial({}, mapear_log(), 0, COLA_RECUPERACION_IDS)) {
+            max_cola = std::max(max_cola, t.id);
+        }
+        max_id = std::max(max_id, max_cola);
+        recorrer_todo = max_cola >= techo_ids;
+    } else {
+        // Primera ejecución (o log migrado): un único recorrido completo
+        techo_ids = 0;
+    }
+    if (recorrer_todo) {
+        RangoTransacciones rango;
+        rango.archivo = mapear_log();
+        for (const auto& t : rango) {
+            max_id = std::max(max_id, t.id);
+        }
+    }
+    
+    siguiente_id = std::max(techo_ids, max_id) + 1;
+    techo_ids = siguiente_id - 1;
+}
+
+bool DatabaseJSON::exportar_transacciones_json(const std::string& destino) {
+    // Se escribe en un temporal: la exportación anterior sigue entera hasta
+    // que la nueva esté completa y sincronizada
+    const std::string& ruta = destino.empty() ? archivo_transacciones : destino;
+    uint64_t cubiertos = 0;
+    {
+        // Lo que se agregue desde acá queda para la próxima exportación
+        std::lock_guard<std::mutex> lock(mtx);
+        cubiertos = cambios_historial;
+    }
+    std::ofstream archivo(io_archivos::ruta_temporal(ruta), std::ios::binary | std::ios::trunc);
+    if (!archivo.is_open()) return false;
+    
+    // Se escribe mientras se recorre el log, en tandas de 1 MiB: la memoria
+    // no crece con el historial. Las cadenas del log ya están escapadas y se
+    // copian tal cual.
+    const size_t tanda = 1024 * 1024;
+    SerializadorJSON buffer;
+    auto volcar = [&] {
+        archivo.write(buffer.texto().data(), static_cast<std::streamsize>(buffer.size()));
+        buffer.limpiar();
+    };
+    buffer.literal("[\n");
+    bool primero = true;
+    for (const auto& t : recorrer_transacciones()) {
+        buffer.literal(primero ? "  {\n    \"id\": " : ",\n  {\n    \"id\": ");
+        primero = false;
+        buffer.entero(t.id);
+        buffer.literal(",\n    \"usuario_origen\": ");
+        buffer.cadena_escapada(t.usuario_origen);
+        buffer.literal(",\n    \"usuario_destino\": ");
+        buffer.cadena_escapada(t.usuario_destino);
+        buffer.literal(",\n    \"monto\": ");
+        buffer.monto(t.monto);
+        buffer.literal(",\n    \"tipo\": ");
+        buffer.cadena_escapada(t.tipo);
+        buffer.literal(",\n    \"es_sospechosa\": ");
+        buffer.booleano(t.es_sospechosa);
+        buffer.literal(",\n    \"fecha\": ");
+        buffer.cadena_escapada(t.fecha);
+        buffer.literal("\n  }");
+        if (buffer.size() >= tanda) volcar();
+    }
+    buffer.literal(primero ? "]\n" : "\n]\n");
+    volcar();
+    archivo.close();
+    
+    if (!archivo.good()) {
+        std::error_code ec;
+        std::filesystem::remove(io_archivos::ruta_temporal(ruta), ec);
+        return false;
+    }
+    if (!io_archivos::confirmar_reemplazo(ruta)) return false;
+    if (destino.empty()) {
+        std::lock_guard<std::mutex> lock(mtx);
+        cambios_exportados = std::max(cambios_exportados, cubiertos);
+    }
+    return true;
+}
+
+void DatabaseJSON::configurar_exportacion_al_cerrar(bool activar) {
+    std::lock_guard<std::mutex> lock(mtx);
+    exportar_al_cerrar = activar;
+}
+
+bool DatabaseJSON::exportar_backup(const std::string& directorio) {
+    // Cada backup es un directorio que se abre como cualquier base:
+    //   <directorio>/backup_<fecha>/  snapshot de usuarios, checkpoint, cola
+    //                                 del log, techo de ids y los segmentos
+    //   <directorio>/segmentos/<log>/ los segmentos sellados de esta base,
+    //                                 copiados una sola vez y enlazados
+    //                                 desde cada backup
+    // El índice por usuario no se copia: se rehace desde el log al abrir.
+    std::string fecha = obtener_fecha_actual();
+    std::replace(fecha.begin(), fecha.end(), ' ', '_');
+    std::replace(fecha.begin(), fecha.end(), ':', '-');
+    
+    std::error_code ec;
+    std::filesystem::path raiz(directorio);
+    // Varias bases pueden respaldarse en el mismo directorio, y sus segmentos
+    // se llaman igual: cada una tiene su almacén, con el nombre de su log y
+    // el CRC de su ruta absoluta
+    std::string ruta_log = std::filesystem::absolute(archivo_log_transacciones, ec).lexically_normal().string();
+    char crc_ruta[9];
+    std::snprintf(crc_ruta, sizeof(crc_ruta), "%08x",
+                  static_cast<unsigned>(io_archivos::calcular_crc32(ruta_log.data(), ruta_log.size())));
+    std::filesystem::path almacen = raiz / "segmentos" /
+        (std::filesystem::path(archivo_log_transacciones).filename().string() + "-" + crc_ruta);
+    std::filesystem::path destino = raiz / ("backup_" + fecha);
+    for (int n = 2; std::filesystem::exists(destino, ec); ++n) {
+        destino = raiz / ("backup_" + fecha + "_" + std::to_string(n));
+    }
+    // Se arma aparte y se renombra al final: un backup a medias nunca
+    // aparece con el nombre definitivo
+    std::filesystem::path temporal = destino;
+    temporal += ".tmp";
+    std::filesystem::create_directories(almacen, ec);
+    if (!ec) std::filesystem::create_directories(temporal, ec);
+    if (ec) {
+        std::cerr << "[DB] No se pudo crear el backup en " << directorio << ": " << ec.message() << std::endl;
+        return false;
+    }
+    auto ruta_en = [](const std::filesystem::path& carpeta, const std::string& archivo) {
+        return (carpeta / std::filesystem::path(archivo).filename()).string();
+    };
+    auto descartar = [&](const char* motivo) {
+        std::cerr << "[DB] Backup en " << destino.string() << " fallido: " << motivo << std::endl;
+        std::error_code ec_borrado;
+        std::filesystem::remove_all(temporal, ec_borrado);
+        return false;
+    };
+    
+    // Bajo el lock se fija un punto consistente: el checkpoint sincroniza el
+    // log, deja el snapshot al día y vacía el log de usuarios. Los mapeos
+    // conservan ese contenido aunque luego un checkpoint o un archivado
+    // reemplacen los archivos, así que la copia se hace ya sin el lock.
+    std::unique_ptr<ArchivoMapeado> snapshot;
+    std::unique_ptr<ArchivoMapeado> log;
+    uint64_t largo_log = 0;
+    std::vector<std::pair<size_t, std::string>> sellados;
+    std::string punto;
+    std::string techo_ids;
+    bool con_techo = false;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!checkpoint_sin_lock()) return descartar("no se pudo hacer el checkpoint");
+        snapshot = std::make_unique<ArchivoMapeado>(archivo_usuarios);
+        log = std::make_unique<ArchivoMapeado>(archivo_log_transacciones);
+        largo_log = tam_log;
+        sellados = listar_segmentos();
+        if (!leer_archivo_completo(archivo_checkpoint, punto)) return descartar("sin checkpoint");
+        con_techo = leer_archivo_completo(archivo_secuencia_ids, techo_ids);
+    }
+    if (!snapshot->esta_abierto() || !log->esta_abierto() || log->contenido().size() < largo_log) {
+        return descartar("no se pudieron leer el snapshot o el log");
+    }
+    
+    // Por backup se copian solo el snapshot y la cola del log
+    uint64_t copiados = snapshot->contenido().size() + largo_log;
+    if (!io_archivos::reemplazar_archivo(ruta_en(temporal, archivo_usuarios), snapshot->contenido()) ||
+        !io_archivos::reemplazar_archivo(ruta_en(temporal, archivo_checkpoint), punto) ||
+        !io_archivos::reemplazar_archivo(ruta_en(temporal, archivo_log_transacciones),
+                                         log->contenido().substr(0, largo_log)) ||
+        (con_techo && !io_archivos::reemplazar_archivo(ruta_en(temporal, archivo_secuencia_ids), techo_ids))) {
+        return descartar("no se pudo escribir el snapshot o la cola del log");
+    }
+    snapshot.reset();
+    log.reset();
+    
+    // Un segmento sellado no cambia: si el almacén ya lo tiene (el mismo
+    // archivo, o una copia con el mismo CRC de cabecera de un backup
+    // anterior) no se vuelve a copiar, y el backup solo lo enlaza. Uno
+    // distinto con el mismo nombre se reemplaza; los backups que lo enlazaban
+    // conservan el suyo.
+    auto crc_cabecera = [](const std::string& ruta, uint32_t& crc) {
+        SegmentoColumnar segmento(ruta);
+        crc = segmento.crc_cabecera();
+        return segmento.esta_abierto();
+    };
+    size_t nuevos = 0;
+    for (const auto& segmento : sellados) {
+        const std::string& ruta = segmento.second;
+        std::string guardado = ruta_en(almacen, ruta);
+        bool presente = std::filesystem::equivalent(ruta, guardado, ec);
+        if (!presente && std::filesystem::exists(guardado, ec)) {
+            uint32_t crc_original = 0, crc_guardado = 0;
+            presente = crc_cabecera(ruta, crc_original) && crc_cabecera(guardado, crc_guardado) &&
+                       crc_original == crc_guardado;
+        }
+        if (!presente) {
+            if (!enlazar_o_copiar(ruta, guardado, copiados)) return descartar("no se pudo guardar un segmento");
+            nuevos++;
+        }
+        if (!enlazar_o_copiar(guardado, ruta_en(temporal, ruta), copiados)) {
+            return descartar("no se pudo enlazar un segmento");
+        }
+    }
     
-    std::ifstream src2(archivo_transacciones, std::ios::binary);
-    std::ofstream dst2(backup_transacciones, std::ios::binary);
-    dst2 << src2.rdbuf();
+    std::filesystem::rename(temporal, destino, ec);
+    if (ec) return descartar("no se pudo renombrar el directorio");
     
+    std::cout << "[DB] Backup en " << destino.string() << ": " << sellados.size() << " segmentos ("
+              << nuevos << " nuevos), " << copiados << " bytes copiados" << std::endl;
     return true;
 }
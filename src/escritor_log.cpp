@@ -0,0 +1,264 @@
+#include "escritor_log.hpp"
+#include "io_archivos.hpp"
+#include <iostream>
+#include <algorithm>
+
+const char* nombre_modo_durabilidad(ModoDurabilidad modo) {
+    switch (modo) {
+        case ModoDurabilidad::NINGUNA:    return "ninguna";
+        case ModoDurabilidad::ASINCRONA:  return "asincrona";
+        case ModoDurabilidad::GRUPO:      return "grupo";
+        case ModoDurabilidad::POR_COMMIT: return "por-commit";
+    }
+    return "?";
+}
+
+EscritorLog::EscritorLog(const std::string& ruta, ModoDurabilidad modo)
+    : ruta(ruta), fd(io_archivos::abrir_para_append(ruta)), modo(modo) {
+    if (fd < 0) {
+        std::cerr << "[LOG] No se pudo abrir " << ruta << " para escritura" << std::endl;
+        error = true;
+        return;
+    }
+    hilo = std::thread(&EscritorLog::ejecutar_escritor, this);
+}
+
+EscritorLog::~EscritorLog() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        detener = true;
+    }
+    cv_escritor.notify_all();
+    if (hilo.joinable()) hilo.join();
+
+    if (fd >= 0) {
+        // Nada de lo aceptado se pierde al cerrar, sea cual sea el modo
+        std::lock_guard<std::mutex> lock(mtx);
+        if (escribir_pendientes_sin_lock() && io_archivos::sincronizar_fd(fd)) {
+            secuencia_durable = secuencia_escrita;
+        }
+        io_archivos::cerrar_fd(fd);
+        fd = -1;
+    }
+    cv_durable.notify_all();
+}
+
+bool EscritorLog::esta_abierto() const {
+    return fd >= 0;
+}
+
+EscritorLog::Contadores& EscritorLog::contadores_de(ModoDurabilidad m) {
+    return contadores[static_cast<size_t>(m)];
+}
+
+bool EscritorLog::agregar(std::string_view datos, Ticket& ticket) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (fd < 0 || error) return false;
+
+    ticket.secuencia = ++ultima_secuencia;
+    ticket.modo = modo;
+    ticket.esperar = false;
+    ticket.inicio = std::chrono::steady_clock::now();
+    Contadores& c = contadores_de(modo);
+    c.bytes += datos.size();
+
+    switch (modo) {
+        case ModoDurabilidad::GRUPO:
+            // El hilo escritor llevará este registro en el próximo lote
+            pendiente.append(datos.data(), datos.size());
+            ticket.esperar = true;
+            cv_escritor.notify_one();
+            return true;
+
+        case ModoDurabilidad::POR_COMMIT:
+            if (!escribir_pendientes_sin_lock() ||
+                !io_archivos::escribir_todo(fd, datos.data(), datos.size()) ||
+                !io_archivos::sincronizar_fd(fd)) {
+                error = true;
+                return false;
+            }
+            secuencia_escrita = secuencia_durable = ticket.secuencia;
+            c.lotes++;
+            c.fsyncs++;
+            // Puede haber committers de un lote de GRUPO anterior al cambio de
+            // modo esperando: sus bytes acaban de sincronizarse con estos
+            cv_durable.notify_all();
+            return true;
+
+        case ModoDurabilidad::NINGUNA:
+        case ModoDurabilidad::ASINCRONA:
+            if (!escribir_pendientes_sin_lock() ||
+                !io_archivos::escribir_todo(fd, datos.data(), datos.size())) {
+                error = true;
+                return false;
+            }
+            secuencia_escrita = ticket.secuencia;
+            if (modo == ModoDurabilidad::NINGUNA) c.lotes++;
+            cv_durable.notify_all();
+            return true;
+    }
+    return false;
+}
+
+bool EscritorLog::esperar_durable(const Ticket& ticket) {
+    std::unique_lock<std::mutex> lock(mtx);
+    if (ticket.esperar) {
+        cv_durable.wait(lock, [&] {
+            return secuencia_durable >= ticket.secuencia || error || fd < 0;
+        });
+        if (secuencia_durable < ticket.secuencia) return false;
+    }
+
+    auto ahora = std::chrono::steady_clock::now();
+    double latencia_us = std::chrono::duration<double, std::micro>(ahora - ticket.inicio).count();
+    Contadores& c = contadores_de(ticket.modo);
+    if (c.commits == 0) c.primer_commit = ticket.inicio;
+    c.commits++;
+    c.latencia_total_us += latencia_us;
+    c.latencia_max_us = std::max(c.latencia_max_us, latencia_us);
+    c.ultimo_commit = ahora;
+    return true;
+}
+
+bool EscritorLog::escribir_pendientes_sin_lock() {
+    if (pendiente.empty()) return true;
+    if (!io_archivos::escribir_todo(fd, pendiente.data(), pendiente.size())) {
+        error = true;
+        cv_durable.notify_all();
+        return false;
+    }
+    pendiente.clear();
+    // Todo ticket entregado está ahora en el archivo (escrito o directo)
+    secuencia_escrita = ultima_secuencia;
+    cv_escritor.notify_one();
+    return true;
+}
+
+bool EscritorLog::escribir_pendientes() {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (fd < 0) return false;
+    return escribir_pendientes_sin_lock();
+}
+
+bool EscritorLog::sincronizar() {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (fd < 0 || !escribir_pendientes_sin_lock()) return false;
+    if (!io_archivos::sincronizar_fd(fd)) return false;
+    secuencia_durable = secuencia_escrita;
+    cv_durable.notify_all();
+    return true;
+}
+
+bool EscritorLog::truncar() {
+    std::unique_lock<std::mutex> lock(mtx);
+    // El descriptor se cambia: no puede haber un fsync en curso sobre él
+    cv_durable.wait(lock, [this] { return !sincronizando; });
+    if (fd < 0 || !escribir_pendientes_sin_lock()) return false;
+    // Todo lo aceptado queda durable antes de descartarlo del archivo
+    if (!io_archivos::sincronizar_fd(fd)) {
+        error = true;
+        cv_durable.notify_all();
+        return false;
+    }
+    secuencia_durable = secuencia_escrita;
+    
+    // No se recorta en el lugar: un archivo vacío reemplaza al anterior, que
+    // sigue intacto para quien lo tenga mapeado (recortarlo bajo un mapeo da
+    // SIGBUS). El descriptor se cierra antes: en Windows no se puede renombrar
+    // sobre un archivo abierto. Si el reemplazo falla, se reabre el mismo
+    // archivo, entero, y se sigue agregando en él.
+    io_archivos::cerrar_fd(fd);
+    bool vaciado = io_archivos::reemplazar_archivo(ruta, "");
+    fd = io_archivos::abrir_para_append(ruta);
+    if (fd < 0) {
+        std::cerr << "[LOG] No se pudo reabrir " << ruta << std::endl;
+        error = true;
+    } else if (!vaciado) {
+        std::cerr << "[LOG] No se pudo vaciar " << ruta << std::endl;
+    }
+    cv_durable.notify_all();
+    return vaciado && fd >= 0;
+}
+
+void EscritorLog::ejecutar_escritor() {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (!detener) {
+        // En modo asíncrono el fsync se hace por intervalo; en grupo, apenas
+        // hay un lote. Mientras dura el fsync el lock está libre y el
+        // siguiente lote se sigue llenando.
+        cv_escritor.wait_for(lock, intervalo_asincrono, [this] {
+            return detener || (!pendiente.empty() && modo == ModoDurabilidad::GRUPO) ||
+                   (secuencia_escrita > secuencia_durable && modo == ModoDurabilidad::GRUPO);
+        });
+        if (detener || error) break;
+
+        if (!escribir_pendientes_sin_lock()) break;
+        if (secuencia_escrita <= secuencia_durable) continue;
+        if (modo == ModoDurabilidad::NINGUNA) {
+            // Sin garantía de durabilidad: basta con que esté escrito
+            secuencia_durable = secuencia_escrita;
+            cv_durable.notify_all();
+            continue;
+        }
+
+        uint64_t objetivo = secuencia_escrita;
+        ModoDurabilidad modo_lote = modo;
+        sincronizando = true;
+        lock.unlock();
+        bool ok = io_archivos::sincronizar_fd(fd);
+        lock.lock();
+        sincronizando = false;
+
+        if (!ok) {
+            std::cerr << "[LOG] fsync falló en " << ruta << std::endl;
+            error = true;
+            cv_durable.notify_all();
+            break;
+        }
+        secuencia_durable = std::max(secuencia_durable, objetivo);
+        Contadores& c = contadores_de(modo_lote);
+        c.lotes++;
+        c.fsyncs++;
+        cv_durable.notify_all();
+    }
+}
+
+void EscritorLog::cambiar_modo(ModoDurabilidad nuevo_modo) {
+    std::lock_guard<std::mutex> lock(mtx);
+    modo = nuevo_modo;
+    cv_escritor.notify_one();
+}
+
+ModoDurabilidad EscritorLog::obtener_modo() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return modo;
+}
+
+void EscritorLog::cambiar_intervalo_asincrono(std::chrono::milliseconds intervalo) {
+    std::lock_guard<std::mutex> lock(mtx);
+    intervalo_asincrono = intervalo;
+}
+
+EstadisticasCommit EscritorLog::estadisticas(ModoDurabilidad modo_consultado) const {
+    std::lock_guard<std::mutex> lock(mtx);
+    const Contadores& c = contadores[static_cast<size_t>(modo_consultado)];
+
+    EstadisticasCommit e{};
+    e.modo = modo_consultado;
+    e.commits = c.commits;
+    e.lotes = c.lotes;
+    e.fsyncs = c.fsyncs;
+    e.bytes = c.bytes;
+    if (c.commits > 0) {
+        e.latencia_media_us = c.latencia_total_us / static_cast<double>(c.commits);
+        e.latencia_max_us = c.latencia_max_us;
+        double segundos = std::chrono::duration<double>(c.ultimo_commit - c.primer_commit).count();
+        e.commits_por_segundo = segundos > 0.0 ? static_cast<double>(c.commits) / segundos : 0.0;
+    }
+    return e;
+}
+
+void EscritorLog::reiniciar_estadisticas() {
+    std::lock_guard<std::mutex> lock(mtx);
+    contadores = {};
+}
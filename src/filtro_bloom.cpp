@@ -0,0 +1,57 @@
+#include "filtro_bloom.hpp"
+#include <algorithm>
+#include <functional>
+
+FiltroBloom::FiltroBloom(size_t capacidad)
+    : capacidad_maxima(std::max<size_t>(1, capacidad)) {
+    // 12 bits por clave: con 6 bits por clave en bloques de 512 bits da
+    // alrededor de 0,5% de falsos positivos a capacidad completa
+    const size_t bits_por_bloque = PALABRAS_POR_BLOQUE * 64;
+    bloques = (capacidad_maxima * 12 + bits_por_bloque - 1) / bits_por_bloque;
+    palabras = std::make_unique<std::atomic<uint64_t>[]>(bloques * PALABRAS_POR_BLOQUE);
+    for (size_t i = 0; i < bloques * PALABRAS_POR_BLOQUE; ++i) {
+        palabras[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+uint64_t FiltroBloom::hash(std::string_view clave) {
+    // El filtro no se persiste: std::hash alcanza. La mezcla final de
+    // MurmurHash3 reparte bien todos los bits, que se usan por separado.
+    uint64_t h = std::hash<std::string_view>{}(clave);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+size_t FiltroBloom::bloque_de(uint64_t h) const {
+    // Los 32 bits altos eligen el bloque (multiplicación en vez de módulo);
+    // los bajos, los bits dentro de él
+    return static_cast<size_t>(((h >> 32) * static_cast<uint64_t>(bloques)) >> 32);
+}
+
+void FiltroBloom::agregar(std::string_view clave) {
+    uint64_t h = hash(clave);
+    std::atomic<uint64_t>* bloque = &palabras[bloque_de(h) * PALABRAS_POR_BLOQUE];
+    uint64_t bits = h * 0x9e3779b97f4a7c15ull;
+    for (int i = 0; i < BITS_POR_CLAVE; ++i, bits >>= 9) {
+        unsigned posicion = static_cast<unsigned>(bits & 511);
+        bloque[posicion >> 6].fetch_or(uint64_t{1} << (posicion & 63), std::memory_order_relaxed);
+    }
+    claves.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool FiltroBloom::puede_contener(std::string_view clave) const {
+    uint64_t h = hash(clave);
+    const std::atomic<uint64_t>* bloque = &palabras[bloque_de(h) * PALABRAS_POR_BLOQUE];
+    uint64_t bits = h * 0x9e3779b97f4a7c15ull;
+    for (int i = 0; i < BITS_POR_CLAVE; ++i, bits >>= 9) {
+        unsigned posicion = static_cast<unsigned>(bits & 511);
+        if (!(bloque[posicion >> 6].load(std::memory_order_relaxed) & (uint64_t{1} << (posicion & 63)))) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,146 @@
+#include "io_archivos.hpp"
+#include <cerrno>
+#include <filesystem>
+#include <fcntl.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace io_archivos {
+
+namespace {
+
+int abrir_para_reemplazo(const std::string& ruta) {
+#ifdef _WIN32
+    return _open(ruta.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    return ::open(ruta.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+}
+
+bool sincronizar_directorio(const std::string& ruta) {
+#ifdef _WIN32
+    // En Windows el rename queda registrado por el propio sistema de archivos
+    (void)ruta;
+    return true;
+#else
+    std::filesystem::path directorio = std::filesystem::path(ruta).parent_path();
+    int fd = ::open(directorio.empty() ? "." : directorio.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    bool ok = sincronizar_fd(fd);
+    cerrar_fd(fd);
+    return ok;
+#endif
+}
+
+bool descartar_temporal(const std::string& temporal) {
+    std::error_code ec;
+    std::filesystem::remove(temporal, ec);
+    return false;
+}
+
+// El temporal ya es durable: el rename lo publica entero o no lo publica, y
+// el fsync del directorio hace durable el rename
+bool renombrar_sincronizado(const std::string& temporal, const std::string& ruta) {
+    std::error_code ec;
+    std::filesystem::rename(temporal, ruta, ec);
+    if (ec) return descartar_temporal(temporal);
+    return sincronizar_directorio(ruta);
+}
+
+} // namespace
+
+int abrir_para_append(const std::string& ruta) {
+#ifdef _WIN32
+    return _open(ruta.c_str(), _O_WRONLY | _O_APPEND | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    return ::open(ruta.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+#endif
+}
+
+bool escribir_todo(int fd, const char* datos, size_t longitud) {
+    while (longitud > 0) {
+#ifdef _WIN32
+        int escritos = _write(fd, datos, static_cast<unsigned int>(longitud));
+#else
+        ssize_t escritos = ::write(fd, datos, longitud);
+#endif
+        if (escritos < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        datos += escritos;
+        longitud -= static_cast<size_t>(escritos);
+    }
+    return true;
+}
+
+bool sincronizar_fd(int fd) {
+#ifdef _WIN32
+    return _commit(fd) == 0;
+#else
+    return ::fsync(fd) == 0;
+#endif
+}
+
+void cerrar_fd(int fd) {
+#ifdef _WIN32
+    _close(fd);
+#else
+    ::close(fd);
+#endif
+}
+
+std::string ruta_temporal(const std::string& ruta) {
+    return ruta + SUFIJO_TEMPORAL;
+}
+
+bool reemplazar_archivo(const std::string& ruta, std::string_view contenido) {
+    std::string temporal = ruta_temporal(ruta);
+    int fd = abrir_para_reemplazo(temporal);
+    if (fd < 0) return false;
+    
+    bool ok = escribir_todo(fd, contenido.data(), contenido.size()) && sincronizar_fd(fd);
+    cerrar_fd(fd);
+    return ok ? renombrar_sincronizado(temporal, ruta) : descartar_temporal(temporal);
+}
+
+bool confirmar_reemplazo(const std::string& ruta) {
+    std::string temporal = ruta_temporal(ruta);
+#ifdef _WIN32
+    int fd = _open(temporal.c_str(), _O_RDWR | _O_BINARY);
+#else
+    int fd = ::open(temporal.c_str(), O_RDONLY);
+#endif
+    if (fd < 0) return descartar_temporal(temporal);
+    bool ok = sincronizar_fd(fd);
+    cerrar_fd(fd);
+    return ok ? renombrar_sincronizado(temporal, ruta) : descartar_temporal(temporal);
+}
+
+uint32_t calcular_crc32(const char* datos, size_t longitud) {
+    static uint32_t tabla[256];
+    static bool tabla_lista = [] {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            tabla[i] = c;
+        }
+        return true;
+    }();
+    (void)tabla_lista;
+    
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < longitud; ++i) {
+        crc = tabla[(crc ^ static_cast<unsigned char>(datos[i])) & 0xFFu] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+} // namespace io_archivos
@@ -0,0 +1,1386 @@
+// Benchmarks de la capa de persistencia (DatabaseJSON)
+//
+// Compilar (o con ./compilar.sh):
+//   g++ -std=c++17 -O2 -pthread -Iinclude src/main_benchmark.cpp
+//       src/database_json.cpp src/escritor_log.cpp src/io_archivos.cpp
+//       src/parser_json.cpp src/archivo_mapeado.cpp src/segmento_columnar.cpp
+//       src/database_fragmentada.cpp src/marcas_tiempo.cpp src/serializador_json.cpp
+//       src/filtro_bloom.cpp -o benchmark_db
+//
+// Uso:
+//   ./benchmark_db commit [hilos] [commits_por_hilo]
+//   ./benchmark_db parse [registros]
+//   ./benchmark_db lectura [registros]
+//   ./benchmark_db archivo [registros]
+//   ./benchmark_db carga [registros]
+//   ./benchmark_db concurrencia [lectores] [segundos]
+//   ./benchmark_db saldos [actualizaciones]
+//   ./benchmark_db reemplazo [usuarios] [repeticiones]
+//   ./benchmark_db caidas [rondas]
+//   ./benchmark_db fragmentos [hilos] [operaciones_por_hilo]
+//   ./benchmark_db compresion [registros]
+//   ./benchmark_db periodo [registros]
+//   ./benchmark_db serializar [registros]
+//   ./benchmark_db existe [usuarios] [consultas]
+//   ./benchmark_db consulta [registros]
+//   ./benchmark_db cache [lecturas]
+//   ./benchmark_db backup [registros]
+
+#include "database_json.hpp"
+#include "database_fragmentada.hpp"
+#include "segmento_columnar.hpp"
+#include "io_archivos.hpp"
+#include "marcas_tiempo.hpp"
+#include "serializador_json.hpp"
+#include "filtro_bloom.hpp"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <thread>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <atomic>
+#include <random>
+#include <cmath>
+#include <cstdio>
+#include <iterator>
+#include <sstream>
+#include <unordered_map>
+
+#ifndef _WIN32
+#include <csignal>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Directorio temporal propio de cada corrida, borrado al terminar
+struct DirectorioTemporal {
+    fs::path ruta;
+
+    explicit DirectorioTemporal(const std::string& nombre)
+        : ruta(fs::temp_directory_path() / ("benchmark_db_" + nombre)) {
+        fs::remove_all(ruta);
+        fs::create_directories(ruta);
+    }
+
+    ~DirectorioTemporal() {
+        std::error_code ec;
+        fs::remove_all(ruta, ec);
+    }
+
+    std::string archivo(const std::string& nombre) const {
+        return (ruta / nombre).string();
+    }
+};
+
+// Latencia y throughput de guardar_transaccion en cada modo de durabilidad
+void benchmark_commit(int hilos, int commits_por_hilo) {
+    const ModoDurabilidad modos[] = {
+        ModoDurabilidad::NINGUNA, ModoDurabilidad::ASINCRONA,
+        ModoDurabilidad::GRUPO, ModoDurabilidad::POR_COMMIT
+    };
+
+    std::cout << "Commits: " << hilos << " hilos x " << commits_por_hilo << "\n\n";
+    std::cout << std::left << std::setw(12) << "modo"
+              << std::right << std::setw(10) << "commits"
+              << std::setw(10) << "lotes"
+              << std::setw(10) << "fsyncs"
+              << std::setw(14) << "lat. media"
+              << std::setw(14) << "lat. max"
+              << std::setw(14) << "commits/s" << "\n";
+
+    for (ModoDurabilidad modo : modos) {
+        DirectorioTemporal dir(nombre_modo_durabilidad(modo));
+        DatabaseJSON db(dir.archivo("usuarios.json"), dir.archivo("transacciones.json"));
+        db.configurar_durabilidad(modo);
+
+        std::vector<std::thread> trabajadores;
+        for (int h = 0; h < hilos; ++h) {
+            trabajadores.emplace_back([&db, commits_por_hilo, h]() {
+                for (int i = 0; i < commits_por_hilo; ++i) {
+                    TransaccionDB t;
+                    t.id = db.obtener_siguiente_id_transaccion();
+                    t.usuario_origen = "Cliente" + std::to_string(h);
+                    t.usuario_destino = "Destino";
+                    t.monto = 100.0 + i;
+                    t.tipo = "TRANSFERENCIA";
+                    t.es_sospechosa = false;
+                    t.fecha = "2025-11-09 12:00:00";
+                    db.guardar_transaccion(t);
+                }
+            });
+        }
+        for (auto& t : trabajadores) t.join();
+
+        EstadisticasCommit e = db.obtener_estadisticas_commit(modo);
+        std::cout << std::left << std::setw(12) << nombre_modo_durabilidad(modo)
+                  << std::right << std::setw(10) << e.commits
+                  << std::setw(10) << e.lotes
+                  << std::setw(10) << e.fsyncs
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(11) << e.latencia_media_us << " us"
+                  << std::setw(11) << e.latencia_max_us << " us"
+                  << std::setw(14) << std::setprecision(0) << e.commits_por_segundo << "\n";
+    }
+}
+
+// Genera 'registros' transacciones en formato de arreglo, con la sangría
+// de exportar_transacciones_json() o minificadas
+void generar_transacciones_json(const std::string& ruta, int registros, bool minificado) {
+    std::ofstream archivo(ruta, std::ios::binary);
+    const char* salto = minificado ? "" : "\n";
+    const char* sangria = minificado ? "" : "    ";
+    const char* separador = minificado ? ":" : ": ";
+
+    archivo << "[" << salto;
+    for (int i = 1; i <= registros; ++i) {
+        archivo << (minificado ? "" : "  ") << "{" << salto
+                << sangria << "\"id\"" << separador << i << "," << salto
+                << sangria << "\"usuario_origen\"" << separador << "\"Cliente" << (i % 97) << "\"," << salto
+                << sangria << "\"usuario_destino\"" << separador << "\"Cliente" << (i % 89) << "\"," << salto
+                << sangria << "\"monto\"" << separador << (i % 5000) << "." << (i % 100 < 10 ? "0" : "")
+                << (i % 100) << "," << salto
+                << sangria << "\"tipo\"" << separador << "\"TRANSFERENCIA\"," << salto
+                << sangria << "\"es_sospechosa\"" << separador << (i % 50 == 0 ? "true" : "false") << ","
+                << salto
+                << sangria << "\"fecha\"" << separador << "\"2025-11-09 12:00:00\"" << salto
+                << (minificado ? "" : "  ") << "}" << (i < registros ? "," : "") << salto;
+    }
+    archivo << "]" << salto;
+}
+
+// Throughput del parser de una pasada sobre un archivo de arreglo JSON
+void benchmark_parse(int registros) {
+    DirectorioTemporal dir("parse");
+    std::cout << "Parseo de transacciones.json: " << registros << " registros\n\n";
+    std::cout << std::left << std::setw(12) << "formato"
+              << std::right << std::setw(10) << "MB"
+              << std::setw(12) << "lectura"
+              << std::setw(12) << "parseo"
+              << std::setw(12) << "MB/s"
+              << std::setw(16) << "registros/s" << "\n";
+
+    for (bool minificado : {false, true}) {
+        std::string ruta = dir.archivo(minificado ? "minificado.json" : "indentado.json");
+        generar_transacciones_json(ruta, registros, minificado);
+
+        auto inicio = std::chrono::steady_clock::now();
+        std::ifstream archivo(ruta, std::ios::binary | std::ios::ate);
+        std::string buffer(static_cast<size_t>(archivo.tellg()), '\0');
+        archivo.seekg(0);
+        archivo.read(&buffer[0], static_cast<std::streamsize>(buffer.size()));
+        auto leido = std::chrono::steady_clock::now();
+
+        std::vector<TransaccionDB> transacciones;
+        transacciones.reserve(static_cast<size_t>(registros));
+        bool ok = DatabaseJSON::parsear_transacciones_json(buffer, transacciones);
+        auto fin = std::chrono::steady_clock::now();
+
+        double mb = static_cast<double>(buffer.size()) / (1024.0 * 1024.0);
+        double seg_lectura = std::chrono::duration<double>(leido - inicio).count();
+        double seg_parseo = std::chrono::duration<double>(fin - leido).count();
+        std::cout << std::left << std::setw(12) << (minificado ? "minificado" : "indentado")
+                  << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(10) << mb
+                  << std::setw(10) << seg_lectura * 1000.0 << "ms"
+                  << std::setw(10) << seg_parseo * 1000.0 << "ms"
+                  << std::setw(12) << mb / seg_parseo
+                  << std::setw(16) << std::setprecision(0)
+                  << static_cast<double>(transacciones.size()) / seg_parseo << "\n";
+        if (!ok || transacciones.size() != static_cast<size_t>(registros)) {
+            std::cout << "  ERROR: se leyeron " << transacciones.size() << " registros\n";
+        }
+    }
+}
+
+// Lectura analítica del historial: copias (cargar_transacciones) contra
+// vistas sobre el log mapeado (mapear_transacciones)
+void benchmark_lectura(int registros) {
+    DirectorioTemporal dir("lectura");
+    DatabaseJSON db(dir.archivo("usuarios.json"), dir.archivo("transacciones.json"));
+    db.configurar_durabilidad(ModoDurabilidad::NINGUNA);
+
+    int primero = db.reservar_ids(registros);
+    if (primero < 1) {
+        std::cout << "  ERROR: no se pudieron reservar ids\n";
+        return;
+    }
+    for (int i = 0; i < registros; ++i) {
+        TransaccionDB t;
+        t.id = primero + i;
+        t.usuario_origen = "Cliente" + std::to_string(i % 97);
+        t.usuario_destino = "Cliente" + std::to_string(i % 89);
+        t.monto = 100.0 + (i % 5000);
+        t.tipo = "TRANSFERENCIA";
+        t.es_sospechosa = (i % 50 == 0);
+        t.fecha = "2025-11-09 12:00:00";
+        db.guardar_transaccion(t);
+    }
+    db.sincronizar_log();
+
+    std::cout << "Lectura del historial: " << registros << " registros\n\n";
+    std::cout << std::left << std::setw(34) << "consulta"
+              << std::right << std::setw(12) << "tiempo"
+              << std::setw(14) << "memoria" << std::setw(14) << "sospechosas" << "\n";
+
+    auto medir = [](const char* nombre, size_t bytes_por_registro, auto&& consulta) {
+        auto inicio = std::chrono::steady_clock::now();
+        auto resultado = consulta();
+        auto fin = std::chrono::steady_clock::now();
+
+        size_t sospechosas = 0;
+        for (const auto& t : resultado) {
+            if (t.es_sospechosa) sospechosas++;
+        }
+        double mb = static_cast<double>(resultado.size() * bytes_por_registro) / (1024.0 * 1024.0);
+        std::cout << std::left << std::setw(34) << nombre
+                  << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(10) << std::chrono::duration<double, std::milli>(fin - inicio).count() << "ms"
+                  << std::setw(11) << mb << " MB"
+                  << std::setw(14) << sospechosas << "\n";
+    };
+
+    // Memoria aproximada: tamaño del registro (las copias suman además el
+    // heap de las cadenas que no caben en el buffer interno de std::string)
+    medir("cargar_transacciones(0)", sizeof(TransaccionDB),
+          [&] { return db.cargar_transacciones(0); });
+    medir("mapear_transacciones(0)", sizeof(TransaccionVista),
+          [&] { return db.mapear_transacciones(0); });
+    medir("cargar_transacciones_usuario(0)", sizeof(TransaccionDB),
+          [&] { return db.cargar_transacciones_usuario("Cliente7", 0); });
+    medir("mapear_transacciones_usuario(0)", sizeof(TransaccionVista),
+          [&] { return db.mapear_transacciones_usuario("Cliente7", 0); });
+
+    // Streaming: un solo registro decodificado a la vez, memoria constante
+    auto recorrer = [&](const char* nombre, size_t limite) {
+        size_t sospechosas = 0;
+        auto inicio = std::chrono::steady_clock::now();
+        db.for_each_transaccion(
+            [](const TransaccionVista& t) { return t.es_sospechosa; },
+            [&](const TransaccionVista&) { return ++sospechosas < limite; });
+        auto fin = std::chrono::steady_clock::now();
+        std::cout << std::left << std::setw(34) << nombre
+                  << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(10) << std::chrono::duration<double, std::milli>(fin - inicio).count() << "ms"
+                  << std::setw(12) << sizeof(TransaccionVista) << " B"
+                  << std::setw(14) << sospechosas << "\n";
+    };
+    recorrer("for_each_transaccion (todas)", static_cast<size_t>(-1));
+    recorrer("for_each_transaccion (primeras 10)", 10);
+}
+
+// Tamaño y recorrido agregado del historial en texto (log) y archivado en
+// segmentos por columnas
+void benchmark_archivo(int registros) {
+    DirectorioTemporal dir("archivo");
+    auto abrir = [&] {
+        auto db = std::make_unique<DatabaseJSON>(dir.archivo("usuarios.json"),
+                                                 dir.archivo("transacciones.json"));
+        db->configurar_durabilidad(ModoDurabilidad::NINGUNA);
+        db->configurar_archivado(0);
+        return db;
+    };
+    auto db = abrir();
+
+    int primero = db->reservar_ids(registros);
+    if (primero < 1) {
+        std::cout << "  ERROR: no se pudieron reservar ids\n";
+        return;
+    }
+    for (int i = 0; i < registros; ++i) {
+        TransaccionDB t;
+        t.id = primero + i;
+        t.usuario_origen = "Cliente" + std::to_string(i % 97);
+        t.usuario_destino = "Cliente" + std::to_string(i % 89);
+        t.monto = 100.0 + (i % 5000) + (i % 100) / 100.0;
+        t.tipo = (i % 7 == 0) ? "DEPOSITO" : "TRANSFERENCIA";
+        t.es_sospechosa = (i % 50 == 0);
+        t.fecha = "2025-11-09 12:" + std::string(i % 60 < 10 ? "0" : "") + std::to_string(i % 60) + ":00";
+        db->guardar_transaccion(t);
+    }
+    db->sincronizar_log();
+
+    std::cout << "Historial archivado: " << registros << " registros\n\n";
+    std::cout << std::left << std::setw(26) << "formato"
+              << std::right << std::setw(12) << "MB"
+              << std::setw(12) << "recorrido"
+              << std::setw(16) << "suma montos"
+              << std::setw(14) << "sospechosas" << "\n";
+
+    auto tamanio = [&](const std::string& prefijo) {
+        uintmax_t total = 0;
+        for (const auto& entrada : fs::directory_iterator(dir.ruta)) {
+            if (entrada.path().filename().string().rfind(prefijo, 0) == 0) total += entrada.file_size();
+        }
+        return static_cast<double>(total) / (1024.0 * 1024.0);
+    };
+
+    // Agregado típico de un análisis: suma de montos y cuenta de sospechosas
+    auto recorrer = [&](const char* nombre, double mb) {
+        double suma = 0.0;
+        size_t sospechosas = 0;
+        auto inicio = std::chrono::steady_clock::now();
+        db->for_each_transaccion(nullptr, [&](const TransaccionVista& t) {
+            suma += t.monto;
+            if (t.es_sospechosa) sospechosas++;
+            return true;
+        });
+        auto fin = std::chrono::steady_clock::now();
+        std::cout << std::left << std::setw(26) << nombre
+                  << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(12) << mb
+                  << std::setw(10) << std::chrono::duration<double, std::milli>(fin - inicio).count() << "ms"
+                  << std::setw(16) << std::setprecision(2) << suma
+                  << std::setw(14) << sospechosas << "\n";
+    };
+
+    recorrer("log de texto", tamanio("transacciones.json.log"));
+    db->archivar_transacciones();
+
+    // Tras reabrir, la primera lectura decodifica las columnas y las
+    // siguientes las reusan
+    db.reset();
+    db = abrir();
+    double mb_segmentos = tamanio("transacciones.json.seg.");
+    recorrer("segmento (primera lectura)", mb_segmentos);
+    recorrer("segmento (decodificado)", mb_segmentos);
+}
+
+// Carga completa del historial (cargar_transacciones(0)) con 1, 2, 4...
+// hilos, hasta uno por núcleo
+void benchmark_carga(int registros) {
+    DirectorioTemporal dir("carga");
+    DatabaseJSON db(dir.archivo("usuarios.json"), dir.archivo("transacciones.json"));
+    db.configurar_durabilidad(ModoDurabilidad::NINGUNA);
+    db.configurar_archivado(0);
+
+    int primero = db.reservar_ids(registros);
+    if (primero < 1) {
+        std::cout << "  ERROR: no se pudieron reservar ids\n";
+        return;
+    }
+    for (int i = 0; i < registros; ++i) {
+        TransaccionDB t;
+        t.id = primero + i;
+        t.usuario_origen = "Cliente" + std::to_string(i % 97);
+        t.usuario_destino = "Cliente" + std::to_string(i % 89);
+        t.monto = 100.0 + (i % 5000);
+        t.tipo = "TRANSFERENCIA";
+        t.es_sospechosa = (i % 50 == 0);
+        t.fecha = "2025-11-09 12:00:00";
+        db.guardar_transaccion(t);
+    }
+    db.sincronizar_log();
+
+    unsigned nucleos = std::max(1u, std::thread::hardware_concurrency());
+    std::cout << "Carga completa del historial: " << registros << " registros, "
+              << nucleos << " núcleos\n\n";
+    std::cout << std::right << std::setw(6) << "hilos"
+              << std::setw(12) << "tiempo"
+              << std::setw(16) << "registros/s"
+              << std::setw(12) << "speedup" << "\n";
+
+    double base_ms = 0.0;
+    for (unsigned hilos = 1; ; hilos = std::min(hilos * 2, nucleos)) {
+        db.configurar_hilos_carga(hilos);
+        auto inicio = std::chrono::steady_clock::now();
+        size_t leidas = db.cargar_transacciones(0).size();
+        auto fin = std::chrono::steady_clock::now();
+
+        double ms = std::chrono::duration<double, std::milli>(fin - inicio).count();
+        if (hilos == 1) base_ms = ms;
+        std::cout << std::setw(6) << hilos
+                  << std::fixed << std::setprecision(1) << std::setw(10) << ms << "ms"
+                  << std::setprecision(0) << std::setw(16) << leidas / (ms / 1000.0)
+                  << std::setprecision(2) << std::setw(11) << base_ms / ms << "x\n";
+        if (leidas != static_cast<size_t>(registros)) {
+            std::cout << "  ERROR: se leyeron " << leidas << " registros\n";
+        }
+        if (hilos == nucleos) break;
+    }
+}
+
+// Latencia de los lectores (saldo y últimas transacciones) sin escritor y
+// con un escritor haciendo transferencias, checkpoints y archivados
+void benchmark_concurrencia(int lectores, int segundos) {
+    DirectorioTemporal dir("concurrencia");
+    DatabaseJSON db(dir.archivo("usuarios.json"), dir.archivo("transacciones.json"));
+    db.configurar_durabilidad(ModoDurabilidad::NINGUNA);
+    db.configurar_checkpoint(std::chrono::milliseconds(200), 2000);
+    db.configurar_archivado(8 * 1024 * 1024);
+
+    const int usuarios = 1000;
+    for (int i = 0; i < usuarios; ++i) {
+        db.guardar_usuario(UsuarioDB{"Cliente" + std::to_string(i), "CTA" + std::to_string(i),
+                                     1000000.0, "2025-11-09 12:00:00"});
+    }
+
+    std::cout << "Lectores: " << lectores << " hilos, " << segundos << " s por fase\n\n";
+    std::cout << std::left << std::setw(16) << "fase"
+              << std::right << std::setw(14) << "lecturas/s"
+              << std::setw(12) << "p50"
+              << std::setw(12) << "p99"
+              << std::setw(12) << "max"
+              << std::setw(14) << "commits/s" << "\n";
+
+    auto fase = [&](const std::string& nombre, bool con_escritor) {
+        std::atomic<bool> detener{false};
+        std::atomic<long> commits{0};
+        std::thread escritor;
+        if (con_escritor) {
+            escritor = std::thread([&] {
+                for (long i = 0; !detener; ++i) {
+                    std::string origen = "Cliente" + std::to_string(i % usuarios);
+                    std::string destino = "Cliente" + std::to_string((i * 7 + 1) % usuarios);
+                    if (origen == destino) continue;
+                    TransaccionDB t{db.obtener_siguiente_id_transaccion(), origen, destino, 1.0,
+                                    "TRANSFERENCIA", false, "2025-11-09 12:00:00"};
+                    if (db.commit_transferencia(origen, destino, 1.0, t)) commits++;
+                }
+            });
+        }
+
+        std::vector<std::vector<double>> latencias(lectores);
+        std::vector<std::thread> hilos;
+        for (int l = 0; l < lectores; ++l) {
+            hilos.emplace_back([&, l] {
+                for (long i = l; !detener; ++i) {
+                    auto inicio = std::chrono::steady_clock::now();
+                    if (i % 10 == 0) {
+                        db.cargar_transacciones(100);
+                    } else {
+                        db.obtener_usuario("Cliente" + std::to_string(i % usuarios));
+                    }
+                    auto fin = std::chrono::steady_clock::now();
+                    latencias[l].push_back(std::chrono::duration<double, std::micro>(fin - inicio).count());
+                }
+            });
+        }
+
+        std::this_thread::sleep_for(std::chrono::seconds(segundos));
+        detener = true;
+        for (auto& hilo : hilos) hilo.join();
+        if (escritor.joinable()) escritor.join();
+
+        std::vector<double> todas;
+        for (const auto& l : latencias) todas.insert(todas.end(), l.begin(), l.end());
+        std::sort(todas.begin(), todas.end());
+        auto percentil = [&](double p) {
+            return todas.empty() ? 0.0 : todas[static_cast<size_t>(p * (todas.size() - 1))];
+        };
+        std::cout << std::left << std::setw(16) << nombre << std::right << std::fixed
+                  << std::setprecision(0) << std::setw(14) << todas.size() / double(segundos)
+                  << std::setprecision(1) << std::setw(10) << percentil(0.5) << "us"
+                  << std::setw(10) << percentil(0.99) << "us"
+                  << std::setw(10) << (todas.empty() ? 0.0 : todas.back()) << "us"
+                  << std::setprecision(0) << std::setw(14) << commits / double(segundos) << "\n";
+    };
+
+    fase("solo lectores", false);
+    fase("con escritor", true);
+}
+
+// actualizar_saldo repetido sobre pocos usuarios: escritura inmediata
+// (un delta con su espera de fsync por llamada) contra escritura diferida
+void benchmark_saldos(int actualizaciones) {
+    const int usuarios = 10;
+    std::cout << "Saldos: " << actualizaciones << " actualizaciones sobre " << usuarios
+              << " usuarios, modo grupo\n\n";
+    std::cout << std::left << std::setw(12) << "escritura"
+              << std::right << std::setw(12) << "tiempo"
+              << std::setw(18) << "actualizaciones/s"
+              << std::setw(14) << "deltas" << "\n";
+
+    for (bool diferida : {false, true}) {
+        DirectorioTemporal dir(diferida ? "saldos_diferida" : "saldos_inmediata");
+        DatabaseJSON db(dir.archivo("usuarios.json"), dir.archivo("transacciones.json"));
+        db.configurar_checkpoint(std::chrono::milliseconds(60000), 1000000000);
+        db.configurar_escritura_diferida(std::chrono::milliseconds(diferida ? 100 : 0), 256);
+        for (int i = 0; i < usuarios; ++i) {
+            db.guardar_usuario(UsuarioDB{"Cliente" + std::to_string(i), "CTA" + std::to_string(i),
+                                         1000.0, "2025-11-09 12:00:00"});
+        }
+        db.sincronizar_log();
+        auto deltas_iniciales = fs::file_size(dir.archivo("usuarios.json.log"));
+
+        auto inicio = std::chrono::steady_clock::now();
+        for (int i = 0; i < actualizaciones; ++i) {
+            db.actualizar_saldo("Cliente" + std::to_string(i % usuarios), 1000.0 + i);
+        }
+        db.flush();
+        auto fin = std::chrono::steady_clock::now();
+
+        // Cada delta ocupa una línea del log de usuarios
+        size_t deltas = 0;
+        std::ifstream log(dir.archivo("usuarios.json.log"));
+        log.seekg(static_cast<std::streamoff>(deltas_iniciales));
+        std::string linea;
+        while (std::getline(log, linea)) deltas++;
+
+        double ms = std::chrono::duration<double, std::milli>(fin - inicio).count();
+        std::cout << std::left << std::setw(12) << (diferida ? "diferida" : "inmediata")
+                  << std::right << std::fixed << std::setprecision(1) << std::setw(10) << ms << "ms"
+                  << std::setprecision(0) << std::setw(18) << actualizaciones / (ms / 1000.0)
+                  << std::setw(14) << deltas << "\n";
+    }
+}
+
+// Costo de reescribir el snapshot de usuarios: en el lugar (lo que hacía
+// la versión original), en el lugar con fsync, y con temporal + fsync +
+// rename + fsync del directorio
+void benchmark_reemplazo(int usuarios, int repeticiones) {
+    DirectorioTemporal dir("reemplazo");
+    std::string ruta = dir.archivo("usuarios.json");
+
+    std::ostringstream snapshot;
+    snapshot << "[\n";
+    for (int i = 0; i < usuarios; ++i) {
+        snapshot << "  {\n    \"nombre\": \"Cliente" << i << "\",\n    \"cuenta_id\": \"CTA" << i
+                 << "\",\n    \"saldo\": 1000.00,\n    \"fecha_creacion\": \"2025-11-09 12:00:00\",\n"
+                 << "    \"lsn\": " << i << "\n  }" << (i + 1 < usuarios ? ",\n" : "\n");
+    }
+    snapshot << "]\n";
+    const std::string contenido = snapshot.str();
+
+    std::cout << "Reescritura de " << usuarios << " usuarios (" << contenido.size() / 1024
+              << " KiB) x " << repeticiones << "\n\n";
+    std::cout << std::left << std::setw(26) << "escritura"
+              << std::right << std::setw(14) << "media"
+              << std::setw(12) << "vs original" << "\n";
+
+    double base_us = 0.0;
+    auto medir = [&](const std::string& nombre, const std::function<bool()>& escribir) {
+        auto inicio = std::chrono::steady_clock::now();
+        for (int i = 0; i < repeticiones; ++i) {
+            if (!escribir()) {
+                std::cout << "  ERROR en " << nombre << "\n";
+                return;
+            }
+        }
+        auto fin = std::chrono::steady_clock::now();
+        double us = std::chrono::duration<double, std::micro>(fin - inicio).count() / repeticiones;
+        if (base_us == 0.0) base_us = us;
+        std::cout << std::left << std::setw(26) << nombre << std::right << std::fixed
+                  << std::setprecision(1) << std::setw(12) << us << "us"
+                  << std::setprecision(2) << std::setw(11) << us / base_us << "x\n";
+    };
+
+    medir("en el lugar (ofstream)", [&] {
+        std::ofstream archivo(ruta, std::ios::trunc);
+        archivo << contenido;
+        archivo.close();
+        return archivo.good();
+    });
+    medir("en el lugar + fsync", [&] {
+        {
+            std::ofstream archivo(ruta, std::ios::trunc);
+            archivo << contenido;
+        }
+        int fd = io_archivos::abrir_para_append(ruta);
+        bool ok = fd >= 0 && io_archivos::sincronizar_fd(fd);
+        if (fd >= 0) io_archivos::cerrar_fd(fd);
+        return ok;
+    });
+    medir("temporal + fsync + rename", [&] {
+        return io_archivos::reemplazar_archivo(ruta, contenido);
+    });
+}
+
+#ifndef _WIN32
+// Inyección de caídas: un proceso hijo hace transferencias con checkpoints,
+// archivados y saldos diferidos frecuentes, y se lo mata con SIGKILL en un
+// momento al azar. Al reabrir se comprueba que la recuperación deja un estado
+// consistente: la suma de saldos se conserva, no quedan temporales, los ids
+// del historial crecen y ningún commit confirmado se perdió.
+void benchmark_caidas(int rondas) {
+    DirectorioTemporal dir("caidas");
+    std::string archivo_usuarios = dir.archivo("usuarios.json");
+    std::string archivo_transacciones = dir.archivo("transacciones.json");
+    const int usuarios = 20;
+    const double saldo_inicial = 1000.0;
+    {
+        DatabaseJSON db(archivo_usuarios, archivo_transacciones);
+        for (int i = 0; i < usuarios; ++i) {
+            db.guardar_usuario(UsuarioDB{"Cliente" + std::to_string(i), "CTA" + std::to_string(i),
+                                         saldo_inicial, "2025-11-09 12:00:00"});
+        }
+    }
+
+    std::mt19937 azar(12345);
+    std::uniform_int_distribution<int> espera_ms(5, 150);
+    int fallas = 0;
+    size_t previas = 0;
+    std::cout << "Caídas inyectadas: " << rondas << " rondas\n\n";
+
+    for (int ronda = 1; ronda <= rondas; ++ronda) {
+        int canal[2];
+        if (::pipe(canal) != 0) return;
+        // Lo que quede en el buffer de salida no debe heredarlo el hijo
+        std::cout.flush();
+        pid_t hijo = ::fork();
+        if (hijo == 0) {
+            ::close(canal[0]);
+            DatabaseJSON db(archivo_usuarios, archivo_transacciones);
+            db.configurar_checkpoint(std::chrono::milliseconds(5), 50);
+            db.configurar_archivado(64 * 1024);
+            db.configurar_escritura_diferida(std::chrono::milliseconds(2), 8);
+            for (long i = ronda; ; ++i) {
+                std::string origen = "Cliente" + std::to_string(i % usuarios);
+                std::string destino = "Cliente" + std::to_string((i * 7 + 3) % usuarios);
+                if (origen == destino) continue;
+                TransaccionDB t{db.obtener_siguiente_id_transaccion(), origen, destino, 1.0,
+                                "TRANSFERENCIA", false, "2025-11-09 12:00:00"};
+                if (db.commit_transferencia(origen, destino, 1.0, t)) {
+                    // Id confirmado: tiene que sobrevivir a la caída
+                    ssize_t escritos = ::write(canal[1], &t.id, sizeof(t.id));
+                    (void)escritos;
+                }
+                if (i % 97 == 0) db.exportar_transacciones_json("");
+            }
+        }
+        ::close(canal[1]);
+        std::this_thread::sleep_for(std::chrono::milliseconds(espera_ms(azar)));
+        ::kill(hijo, SIGKILL);
+        ::waitpid(hijo, nullptr, 0);
+
+        int confirmado = 0;
+        int id = 0;
+        while (::read(canal[0], &id, sizeof(id)) == static_cast<ssize_t>(sizeof(id))) confirmado = id;
+        ::close(canal[0]);
+
+        DatabaseJSON db(archivo_usuarios, archivo_transacciones);
+        std::vector<std::string> errores;
+        auto tabla = db.cargar_usuarios();
+        double suma = 0.0;
+        for (const auto& u : tabla) suma += u.saldo;
+        if (tabla.size() != static_cast<size_t>(usuarios)) errores.push_back("usuarios perdidos");
+        if (std::abs(suma - usuarios * saldo_inicial) > 1e-6) errores.push_back("la suma de saldos cambió");
+
+        auto historial = db.cargar_transacciones(0);
+        int ultimo = 0;
+        bool ordenado = true;
+        for (const auto& t : historial) {
+            ordenado = ordenado && t.id > ultimo;
+            ultimo = t.id;
+        }
+        if (!ordenado) errores.push_back("ids fuera de orden");
+        if (ultimo < confirmado) errores.push_back("commit confirmado perdido");
+        if (historial.size() < previas) errores.push_back("el historial retrocedió");
+        previas = historial.size();
+
+        for (const auto& entrada : fs::directory_iterator(dir.ruta)) {
+            std::string nombre = entrada.path().filename().string();
+            if (nombre.size() > 4 && nombre.compare(nombre.size() - 4, 4, ".tmp") == 0) {
+                errores.push_back("temporal sin limpiar: " + nombre);
+            }
+        }
+
+        std::cout << "ronda " << std::setw(3) << ronda << ": " << std::setw(7) << historial.size()
+                  << " transacciones, confirmado " << std::setw(7) << confirmado
+                  << (errores.empty() ? "  ok" : "  FALLA") << "\n";
+        for (const auto& error : errores) std::cout << "    " << error << "\n";
+        if (!errores.empty()) fallas++;
+    }
+    std::cout << "\n" << (rondas - fallas) << "/" << rondas << " recuperaciones consistentes\n";
+}
+#endif
+
+// Operaciones de una sola cuenta y transferencias con 1, 2, 4 y 8
+// fragmentos; fsync por commit, para que el mutex de escritura de cada
+// fragmento sea lo que limita
+void benchmark_fragmentos(int hilos, int operaciones) {
+    const int usuarios = 64;
+    std::cout << "Fragmentos: " << hilos << " hilos x " << operaciones
+              << " operaciones, durabilidad por-commit\n\n";
+    std::cout << std::right << std::setw(10) << "fragmentos"
+              << std::setw(18) << "una cuenta/s"
+              << std::setw(18) << "transferencias/s"
+              << std::setw(14) << "cruzadas" << "\n";
+
+    for (size_t cantidad : {1, 2, 4, 8}) {
+        DirectorioTemporal dir("fragmentos_" + std::to_string(cantidad));
+        DatabaseFragmentada db(cantidad, dir.archivo("usuarios.json"), dir.archivo("transacciones.json"));
+        for (int i = 0; i < usuarios; ++i) {
+            db.guardar_usuario(UsuarioDB{"Cliente" + std::to_string(i), "CTA" + std::to_string(i),
+                                         1000000.0, "2025-11-09 12:00:00"});
+        }
+        db.configurar_durabilidad(ModoDurabilidad::POR_COMMIT);
+
+        auto medir = [&](bool transferencias) {
+            std::vector<std::thread> trabajadores;
+            auto inicio = std::chrono::steady_clock::now();
+            for (int h = 0; h < hilos; ++h) {
+                trabajadores.emplace_back([&, h] {
+                    for (int i = 0; i < operaciones; ++i) {
+                        // Cada hilo trabaja sobre sus propias cuentas
+                        int cuenta = (h + i * hilos) % usuarios;
+                        std::string nombre = "Cliente" + std::to_string(cuenta);
+                        TransaccionDB t{db.obtener_siguiente_id_transaccion(), nombre, nombre, 1.0,
+                                        "DEPOSITO", false, "2025-11-09 12:00:00"};
+                        if (!transferencias) {
+                            db.guardar_transaccion(t);
+                        } else {
+                            std::string destino = "Cliente" + std::to_string((cuenta + 1) % usuarios);
+                            t.tipo = "TRANSFERENCIA";
+                            db.commit_transferencia(nombre, destino, 1.0, t);
+                        }
+                    }
+                });
+            }
+            for (auto& trabajador : trabajadores) trabajador.join();
+            auto fin = std::chrono::steady_clock::now();
+            return hilos * operaciones / std::chrono::duration<double>(fin - inicio).count();
+        };
+
+        int cruzadas = 0;
+        for (int i = 0; i < usuarios; ++i) {
+            cruzadas += db.fragmento_de_cuenta("CTA" + std::to_string(i)) !=
+                        db.fragmento_de_cuenta("CTA" + std::to_string((i + 1) % usuarios));
+        }
+        double una_cuenta = medir(false);
+        double transferencias = medir(true);
+        std::cout << std::setw(10) << cantidad << std::fixed << std::setprecision(0)
+                  << std::setw(18) << una_cuenta
+                  << std::setw(18) << transferencias
+                  << std::setw(13) << (100 * cruzadas / usuarios) << "%\n";
+    }
+}
+
+// Tamaño del historial en texto, por columnas y por columnas + LZ, y
+// velocidad de decodificación completa y de un rango de ids (un bloque)
+void benchmark_compresion(int registros) {
+    DirectorioTemporal dir("compresion");
+    DatabaseJSON db(dir.archivo("usuarios.json"), dir.archivo("transacciones.json"));
+    db.configurar_durabilidad(ModoDurabilidad::NINGUNA);
+    db.configurar_archivado(0);
+
+    std::mt19937 azar(42);
+    std::uniform_int_distribution<int> centavos(100, 500000);
+    std::uniform_int_distribution<int> clientes(0, 999);
+    int primero = db.reservar_ids(registros);
+    if (primero < 1) {
+        std::cout << "  ERROR: no se pudieron reservar ids\n";
+        return;
+    }
+    for (int i = 0; i < registros; ++i) {
+        TransaccionDB t;
+        t.id = primero + i;
+        t.usuario_origen = "Cliente" + std::to_string(clientes(azar));
+        t.usuario_destino = "Cliente" + std::to_string(clientes(azar));
+        t.monto = centavos(azar) / 100.0;
+        t.tipo = (i % 7 == 0) ? "DEPOSITO" : "TRANSFERENCIA";
+        t.es_sospechosa = t.monto > 4900.0;
+        int segundo = i / 3;
+        char fecha[32];
+        std::snprintf(fecha, sizeof(fecha), "2025-11-%02d %02d:%02d:%02d",
+                      1 + segundo / 86400 % 28, segundo / 3600 % 24, segundo / 60 % 60, segundo % 60);
+        t.fecha = fecha;
+        db.guardar_transaccion(t);
+    }
+    db.sincronizar_log();
+
+    std::string log;
+    {
+        std::ifstream entrada(dir.archivo("transacciones.json.log"), std::ios::binary);
+        log.assign(std::istreambuf_iterator<char>(entrada), std::istreambuf_iterator<char>());
+    }
+    HistorialMapeado historial = db.mapear_transacciones(0);
+    std::vector<TransaccionVista> vistas(historial.begin(), historial.end());
+
+    std::cout << "Compresión del historial: " << vistas.size() << " registros, bloques de "
+              << SegmentoColumnar::FILAS_POR_BLOQUE << " filas\n\n";
+    std::cout << std::left << std::setw(18) << "formato"
+              << std::right << std::setw(10) << "MB"
+              << std::setw(10) << "ratio"
+              << std::setw(14) << "decodificar"
+              << std::setw(14) << "MB/s (log)"
+              << std::setw(14) << "rango 100 ids" << "\n";
+
+    const double mb_log = log.size() / (1024.0 * 1024.0);
+    std::cout << std::left << std::setw(18) << "log de texto"
+              << std::right << std::fixed << std::setprecision(1) << std::setw(10) << mb_log
+              << std::setprecision(2) << std::setw(9) << 1.0 << "x\n";
+
+    for (bool comprimir : {false, true}) {
+        std::string ruta = dir.archivo(comprimir ? "lz.seg" : "columnas.seg");
+        std::string contenido = SegmentoColumnar::codificar(vistas, log, comprimir);
+        io_archivos::reemplazar_archivo(ruta, contenido);
+
+        // Cada medición abre el segmento de nuevo: nada viene decodificado
+        auto inicio = std::chrono::steady_clock::now();
+        bool ok = SegmentoColumnar(ruta).verificar();
+        auto fin = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(fin - inicio).count();
+
+        int centro = primero + registros / 2;
+        std::vector<TransaccionVista> filas;
+        BloquesDecodificados bloques;
+        auto inicio_rango = std::chrono::steady_clock::now();
+        SegmentoColumnar(ruta).vistas_por_id(centro, centro + 99, filas, bloques);
+        auto fin_rango = std::chrono::steady_clock::now();
+        double ms_rango = std::chrono::duration<double, std::milli>(fin_rango - inicio_rango).count();
+
+        double mb = contenido.size() / (1024.0 * 1024.0);
+        std::cout << std::left << std::setw(18) << (comprimir ? "columnas + LZ" : "columnas")
+                  << std::right << std::setprecision(1) << std::setw(10) << mb
+                  << std::setprecision(2) << std::setw(9) << mb_log / mb << "x"
+                  << std::setprecision(1) << std::setw(12) << ms << "ms"
+                  << std::setprecision(0) << std::setw(14) << mb_log / (ms / 1000.0)
+                  << std::setprecision(3) << std::setw(12) << ms_rango << "ms\n";
+        if (!ok || filas.size() != 100) std::cout << "  ERROR: el segmento no se decodificó completo\n";
+    }
+}
+
+// Consulta por período con los índices temporales contra un recorrido
+// completo que filtra por fecha
+void benchmark_periodo(int registros) {
+    DirectorioTemporal dir("periodo");
+    DatabaseJSON db(dir.archivo("usuarios.json"), dir.archivo("transacciones.json"));
+    db.configurar_durabilidad(ModoDurabilidad::NINGUNA);
+    db.configurar_archivado(0);
+
+    // Una transacción cada 10 s; la mitad queda archivada en segmentos
+    const int64_t inicio = 1735700000;
+    int primero = db.reservar_ids(registros);
+    if (primero < 1) {
+        std::cout << "  ERROR: no se pudieron reservar ids\n";
+        return;
+    }
+    for (int i = 0; i < registros; ++i) {
+        TransaccionDB t;
+        t.id = primero + i;
+        t.usuario_origen = "Cliente" + std::to_string(i % 97);
+        t.usuario_destino = "Cliente" + std::to_string(i % 89);
+        t.monto = 100.0 + (i % 5000);
+        t.tipo = "TRANSFERENCIA";
+        t.es_sospechosa = false;
+        t.fecha = marcas_tiempo::formatear(inicio + 10 * static_cast<int64_t>(i));
+        db.guardar_transaccion(t);
+        if (i == registros / 2) db.archivar_transacciones();
+    }
+    db.sincronizar_log();
+
+    std::cout << "Consulta por período: " << registros << " registros, una cada 10 s\n\n";
+    std::cout << std::left << std::setw(28) << "período"
+              << std::right << std::setw(12) << "filas"
+              << std::setw(14) << "índice"
+              << std::setw(14) << "recorrido" << "\n";
+
+    // Una hora en el historial archivado, una en el log y un día entero
+    const int64_t una_hora = 3600;
+    const int64_t cuarto = 10 * static_cast<int64_t>(registros) / 4;
+    const struct { const char* nombre; int64_t desde; int64_t hasta; } periodos[] = {
+        {"1 hora (segmentos)", inicio + cuarto, inicio + cuarto + una_hora},
+        {"1 hora (log)", inicio + 3 * cuarto, inicio + 3 * cuarto + una_hora},
+        {"1 día", inicio + 2 * cuarto, inicio + 2 * cuarto + 24 * una_hora},
+    };
+    for (const auto& periodo : periodos) {
+        // La primera consulta decodifica los bloques: se mide la segunda
+        db.mapear_transacciones_periodo(periodo.desde, periodo.hasta);
+        auto inicio_indice = std::chrono::steady_clock::now();
+        size_t filas = db.mapear_transacciones_periodo(periodo.desde, periodo.hasta).size();
+        auto fin_indice = std::chrono::steady_clock::now();
+
+        size_t filas_recorrido = 0;
+        auto inicio_recorrido = std::chrono::steady_clock::now();
+        db.for_each_transaccion(
+            [&](const TransaccionVista& t) {
+                int64_t segundos = 0;
+                return marcas_tiempo::a_segundos(t.fecha, segundos) &&
+                       segundos >= periodo.desde && segundos <= periodo.hasta;
+            },
+            [&](const TransaccionVista&) {
+                filas_recorrido++;
+                return true;
+            });
+        auto fin_recorrido = std::chrono::steady_clock::now();
+
+        std::cout << std::left << std::setw(28) << periodo.nombre
+                  << std::right << std::setw(12) << filas
+                  << std::fixed << std::setprecision(3)
+                  << std::setw(12) << std::chrono::duration<double, std::milli>(fin_indice - inicio_indice).count() << "ms"
+                  << std::setw(12) << std::chrono::duration<double, std::milli>(fin_recorrido - inicio_recorrido).count() << "ms\n";
+        if (filas != filas_recorrido) std::cout << "  ERROR: el recorrido encontró " << filas_recorrido << "\n";
+    }
+}
+
+// Registro del log con iostream, como lo escribía DatabaseJSON antes de
+// SerializadorJSON: un ostringstream y tres copias por registro
+std::string enmarcar_con_iostream(const TransaccionDB& t, uint64_t lsn) {
+    auto escapar = [](const std::string& texto) {
+        std::string resultado;
+        SerializadorJSON::escapar(texto, resultado);
+        return resultado;
+    };
+    std::ostringstream oss;
+    oss << "{\"lsn\":" << lsn
+        << ",\"id\":" << t.id
+        << ",\"usuario_origen\":\"" << escapar(t.usuario_origen) << "\""
+        << ",\"usuario_destino\":\"" << escapar(t.usuario_destino) << "\""
+        << ",\"monto\":" << std::fixed << std::setprecision(2) << t.monto
+        << ",\"tipo\":\"" << escapar(t.tipo) << "\""
+        << ",\"es_sospechosa\":" << (t.es_sospechosa ? "true" : "false")
+        << ",\"fecha\":\"" << escapar(t.fecha) << "\"}";
+    std::string json = oss.str();
+    char cabecera[20];
+    std::snprintf(cabecera, sizeof(cabecera), "%08zx %08x ",
+                  json.size(), io_archivos::calcular_crc32(json.data(), json.size()));
+    return cabecera + json + "\n";
+}
+
+// El mismo registro con SerializadorJSON, agregado al final del buffer
+void enmarcar_con_serializador(const TransaccionDB& t, uint64_t lsn, SerializadorJSON& destino) {
+    destino.abrir_registro();
+    destino.literal("{\"lsn\":");
+    destino.natural(lsn);
+    destino.literal(",\"id\":");
+    destino.entero(t.id);
+    destino.literal(",\"usuario_origen\":");
+    destino.cadena(t.usuario_origen);
+    destino.literal(",\"usuario_destino\":");
+    destino.cadena(t.usuario_destino);
+    destino.literal(",\"monto\":");
+    destino.monto(t.monto);
+    destino.literal(",\"tipo\":");
+    destino.cadena(t.tipo);
+    destino.literal(",\"es_sospechosa\":");
+    destino.booleano(t.es_sospechosa);
+    destino.literal(",\"fecha\":");
+    destino.cadena(t.fecha);
+    destino.literal("}");
+    destino.cerrar_registro();
+}
+
+// Registros del log por segundo: iostream (un write por registro) contra
+// SerializadorJSON (buffer reutilizado, un write por tanda)
+void benchmark_serializar(int registros) {
+    DirectorioTemporal dir("serializar");
+    std::vector<TransaccionDB> transacciones(static_cast<size_t>(registros));
+    for (int i = 0; i < registros; ++i) {
+        TransaccionDB& t = transacciones[static_cast<size_t>(i)];
+        t.id = i + 1;
+        t.usuario_origen = "Cliente" + std::to_string(i % 97);
+        t.usuario_destino = (i % 1000 == 0) ? "Cliente \"especial\"" : "Cliente" + std::to_string(i % 89);
+        t.monto = (i % 500000) / 100.0;
+        t.tipo = "TRANSFERENCIA";
+        t.es_sospechosa = i % 50 == 0;
+        t.fecha = "2025-11-09 12:00:00";
+    }
+
+    const size_t tanda = 256;
+    std::string salida_iostream;
+    std::string salida_serializador;
+
+    auto medir = [&](const char* nombre, const std::string& ruta, auto&& escribir) {
+        int fd = io_archivos::abrir_para_append(ruta);
+        auto inicio = std::chrono::steady_clock::now();
+        escribir(fd);
+        auto fin = std::chrono::steady_clock::now();
+        io_archivos::cerrar_fd(fd);
+        double segundos = std::chrono::duration<double>(fin - inicio).count();
+        double megabytes = static_cast<double>(fs::file_size(ruta)) / (1024.0 * 1024.0);
+        std::cout << std::left << std::setw(22) << nombre << std::right << std::fixed
+                  << std::setprecision(0) << std::setw(14) << registros / segundos << " reg/s"
+                  << std::setprecision(1) << std::setw(10) << megabytes / segundos << " MB/s"
+                  << std::setprecision(3) << std::setw(10) << segundos << " s\n";
+    };
+
+    std::cout << "Serialización del log: " << registros << " registros, tandas de " << tanda << "\n\n";
+    medir("iostream", dir.archivo("iostream.log"), [&](int fd) {
+        for (size_t i = 0; i < transacciones.size(); ++i) {
+            std::string linea = enmarcar_con_iostream(transacciones[i], i + 1);
+            io_archivos::escribir_todo(fd, linea.data(), linea.size());
+        }
+    });
+    medir("SerializadorJSON", dir.archivo("serializador.log"), [&](int fd) {
+        SerializadorJSON serializador;
+        for (size_t i = 0; i < transacciones.size(); i += tanda) {
+            serializador.limpiar();
+            size_t fin = std::min(transacciones.size(), i + tanda);
+            for (size_t j = i; j < fin; ++j) enmarcar_con_serializador(transacciones[j], j + 1, serializador);
+            io_archivos::escribir_todo(fd, serializador.texto().data(), serializador.size());
+        }
+    });
+
+    std::ifstream a(dir.archivo("iostream.log"), std::ios::binary);
+    std::ifstream b(dir.archivo("serializador.log"), std::ios::binary);
+    bool iguales = std::equal(std::istreambuf_iterator<char>(a), std::istreambuf_iterator<char>(),
+                              std::istreambuf_iterator<char>(b), std::istreambuf_iterator<char>());
+    std::cout << "\nSalidas " << (iguales ? "idénticas" : "DISTINTAS") << "\n";
+}
+
+// Búsquedas de nombres que existen y que no: el unordered_map solo (lo que
+// hacía usuario_existe sin filtro), con el filtro de Bloom delante, y
+// usuario_existe completo (incluye tomar la versión publicada)
+void benchmark_existe(int usuarios, int consultas) {
+    DirectorioTemporal dir("existe");
+    {
+        SerializadorJSON snapshot;
+        snapshot.literal("[\n");
+        for (int i = 0; i < usuarios; ++i) {
+            snapshot.literal("  {\"nombre\": ");
+            snapshot.cadena("Cliente" + std::to_string(i));
+            snapshot.literal(", \"cuenta_id\": ");
+            snapshot.cadena("CTA" + std::to_string(i));
+            snapshot.literal(", \"saldo\": 1000.00, \"fecha_creacion\": \"2025-11-09 12:00:00\", \"lsn\": 0}");
+            snapshot.literal(i + 1 < usuarios ? ",\n" : "\n");
+        }
+        snapshot.literal("]\n");
+        io_archivos::reemplazar_archivo(dir.archivo("usuarios.json"), snapshot.texto());
+    }
+    DatabaseJSON db(dir.archivo("usuarios.json"), dir.archivo("transacciones.json"));
+
+    std::unordered_map<std::string, size_t> indice;
+    FiltroBloom filtro(static_cast<size_t>(usuarios));
+    for (int i = 0; i < usuarios; ++i) {
+        indice.emplace("Cliente" + std::to_string(i), static_cast<size_t>(i));
+        filtro.agregar("Cliente" + std::to_string(i));
+    }
+
+    // Mismo largo que los nombres existentes: el costo de hashear es igual
+    std::vector<std::string> presentes;
+    std::vector<std::string> ausentes;
+    std::mt19937 azar(7);
+    for (int i = 0; i < consultas && i < 100000; ++i) {
+        presentes.push_back("Cliente" + std::to_string(azar() % static_cast<unsigned>(usuarios)));
+        ausentes.push_back("Clienta" + std::to_string(azar() % static_cast<unsigned>(usuarios)));
+    }
+
+    std::cout << "usuario_existe: " << usuarios << " usuarios, " << consultas << " consultas\n\n";
+    std::cout << std::left << std::setw(26) << "búsqueda"
+              << std::right << std::setw(14) << "existentes"
+              << std::setw(14) << "inexistentes" << "\n";
+
+    auto medir = [&](const char* nombre, auto&& buscar) {
+        auto pasada = [&](const std::vector<std::string>& claves, size_t& encontrados) {
+            auto inicio = std::chrono::steady_clock::now();
+            for (int i = 0; i < consultas; ++i) {
+                encontrados += buscar(claves[static_cast<size_t>(i) % claves.size()]) ? 1 : 0;
+            }
+            auto fin = std::chrono::steady_clock::now();
+            return std::chrono::duration<double, std::nano>(fin - inicio).count() / consultas;
+        };
+        size_t encontrados_presentes = 0;
+        size_t encontrados_ausentes = 0;
+        double ns_presentes = pasada(presentes, encontrados_presentes);
+        double ns_ausentes = pasada(ausentes, encontrados_ausentes);
+        std::cout << std::left << std::setw(26) << nombre << std::right << std::fixed
+                  << std::setprecision(1) << std::setw(12) << ns_presentes << "ns"
+                  << std::setw(12) << ns_ausentes << "ns";
+        if (encontrados_presentes != static_cast<size_t>(consultas) || encontrados_ausentes != 0) {
+            std::cout << "  ERROR";
+        }
+        std::cout << "\n";
+    };
+    medir("unordered_map", [&](const std::string& nombre) { return indice.count(nombre) > 0; });
+    medir("Bloom + unordered_map", [&](const std::string& nombre) {
+        return filtro.puede_contener(nombre) && indice.count(nombre) > 0;
+    });
+    medir("usuario_existe", [&](const std::string& nombre) { return db.usuario_existe(nombre); });
+
+    size_t falsos = 0;
+    for (const auto& nombre : ausentes) falsos += filtro.puede_contener(nombre) ? 1 : 0;
+    std::cout << "\nFalsos positivos del filtro a capacidad completa: " << std::setprecision(2)
+              << 100.0 * static_cast<double>(falsos) / static_cast<double>(ausentes.size()) << "%\n";
+}
+
+// Consultas con filtros y agregados: cargar todo y filtrar en el llamador,
+// recorrer con un predicado, y resumir_transacciones (filtros en la lectura)
+void benchmark_consulta(int registros) {
+    DirectorioTemporal dir("consulta");
+    DatabaseJSON db(dir.archivo("usuarios.json"), dir.archivo("transacciones.json"));
+    db.configurar_durabilidad(ModoDurabilidad::NINGUNA);
+    db.configurar_archivado(0);
+
+    // Una transacción cada 10 s; la mitad queda archivada en segmentos
+    const int64_t inicio = 1735700000;
+    int primero = db.reservar_ids(registros);
+    if (primero < 1) {
+        std::cout << "  ERROR: no se pudieron reservar ids\n";
+        return;
+    }
+    for (int i = 0; i < registros; ++i) {
+        TransaccionDB t;
+        t.id = primero + i;
+        t.usuario_origen = "Cliente" + std::to_string(i % 97);
+        t.usuario_destino = "Cliente" + std::to_string(i % 89);
+        t.monto = 100.0 + (i % 5000);
+        t.tipo = (i % 3 == 0) ? "DEPOSITO" : "TRANSFERENCIA";
+        t.es_sospechosa = (i % 50 == 0);
+        t.fecha = marcas_tiempo::formatear(inicio + 10 * static_cast<int64_t>(i));
+        db.guardar_transaccion(t);
+        if (i == registros / 2) db.archivar_transacciones();
+    }
+    db.sincronizar_log();
+
+    const int64_t fin = inicio + 10 * static_cast<int64_t>(registros);
+    ConsultaTransacciones usuario_hora;
+    usuario_hora.usuario = "Cliente7";
+    usuario_hora.tipo = "TRANSFERENCIA";
+    usuario_hora.es_sospechosa = true;
+    usuario_hora.monto_minimo = 1000.0;
+    usuario_hora.desde = fin - 24 * 3600;
+    ConsultaTransacciones sospechosas;
+    sospechosas.es_sospechosa = true;
+    sospechosas.monto_minimo = 4000.0;
+
+    std::cout << "Consultas con filtros: " << registros << " registros\n\n";
+    std::cout << std::left << std::setw(34) << "consulta"
+              << std::right << std::setw(14) << "cargar+filtro"
+              << std::setw(14) << "predicado"
+              << std::setw(14) << "resumir" << std::setw(10) << "filas" << "\n";
+
+    auto cumple = [](const ConsultaTransacciones& c, const TransaccionVista& t) {
+        int64_t segundos = 0;
+        bool con_periodo = c.desde != INT64_MIN || c.hasta != INT64_MAX;
+        return (c.usuario.empty() || t.usuario_origen == c.usuario || t.usuario_destino == c.usuario) &&
+               (c.tipo.empty() || t.tipo == c.tipo) &&
+               (!c.es_sospechosa || t.es_sospechosa == *c.es_sospechosa) &&
+               t.monto >= c.monto_minimo && t.monto <= c.monto_maximo &&
+               (!con_periodo || (marcas_tiempo::a_segundos(t.fecha, segundos) &&
+                                 segundos >= c.desde && segundos <= c.hasta));
+    };
+    auto milisegundos = [](auto&& tarea) {
+        auto inicio_tarea = std::chrono::steady_clock::now();
+        tarea();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - inicio_tarea).count();
+    };
+
+    const struct { const char* nombre; const ConsultaTransacciones& consulta; } consultas[] = {
+        {"usuario, sospechosas, último día", usuario_hora},
+        {"sospechosas con monto >= 4000", sospechosas},
+    };
+    for (const auto& c : consultas) {
+        size_t con_carga = 0;
+        double ms_carga = milisegundos([&] {
+            for (const auto& t : db.cargar_transacciones(0)) {
+                TransaccionVista v;
+                v.usuario_origen = t.usuario_origen;
+                v.usuario_destino = t.usuario_destino;
+                v.tipo = t.tipo;
+                v.monto = t.monto;
+                v.es_sospechosa = t.es_sospechosa;
+                v.fecha = t.fecha;
+                con_carga += cumple(c.consulta, v) ? 1 : 0;
+            }
+        });
+        size_t con_predicado = 0;
+        double ms_predicado = milisegundos([&] {
+            con_predicado = db.for_each_transaccion(
+                [&](const TransaccionVista& t) { return cumple(c.consulta, t); },
+                [](const TransaccionVista&) { return true; });
+        });
+        db.resumir_transacciones(c.consulta);   // Decodifica los bloques
+        ResumenTransacciones resumen;
+        double ms_resumen = milisegundos([&] { resumen = db.resumir_transacciones(c.consulta); });
+
+        std::cout << std::left << std::setw(34) << c.nombre << std::right << std::fixed
+                  << std::setprecision(2) << std::setw(12) << ms_carga << "ms"
+                  << std::setw(12) << ms_predicado << "ms"
+                  << std::setw(12) << ms_resumen << "ms" << std::setw(10) << resumen.cantidad << "\n";
+        if (con_carga != resumen.cantidad || con_predicado != resumen.cantidad) {
+            std::cout << "  ERROR: " << con_carga << " / " << con_predicado << " filas\n";
+        }
+    }
+}
+
+// Lecturas repetidas de la historia reciente (lo que hace la GUI al
+// refrescar): sin caché, con caché y con una escritura cada tanto
+void benchmark_cache(int lecturas) {
+    DirectorioTemporal dir("cache");
+    DatabaseJSON db(dir.archivo("usuarios.json"), dir.archivo("transacciones.json"));
+    db.configurar_durabilidad(ModoDurabilidad::NINGUNA);
+    db.guardar_usuario({"Cliente1", "CTA1", 1e9, "2025-11-09 12:00:00"});
+    db.guardar_usuario({"Cliente2", "CTA2", 1e9, "2025-11-09 12:00:00"});
+    auto transaccion = [&] {
+        return TransaccionDB{db.obtener_siguiente_id_transaccion(), "Cliente1", "Cliente2", 10.0,
+                             "TRANSFERENCIA", false, "2025-11-09 12:00:00"};
+    };
+    for (int i = 0; i < 100000; ++i) db.guardar_transaccion(transaccion());
+
+    std::cout << "cargar_transacciones(100) x " << lecturas << "\n\n";
+    std::cout << std::left << std::setw(30) << "modo"
+              << std::right << std::setw(14) << "por lectura"
+              << std::setw(12) << "aciertos" << "\n";
+
+    auto medir = [&](const char* nombre, size_t entradas, int escribir_cada) {
+        db.configurar_cache(entradas);
+        EstadisticasCache antes = db.obtener_estadisticas_cache();
+        auto inicio = std::chrono::steady_clock::now();
+        for (int i = 0; i < lecturas; ++i) {
+            if (escribir_cada > 0 && i % escribir_cada == 0) db.guardar_transaccion(transaccion());
+            if (db.cargar_transacciones(100).size() != 100) std::cout << "  ERROR\n";
+        }
+        auto fin = std::chrono::steady_clock::now();
+        EstadisticasCache despues = db.obtener_estadisticas_cache();
+        std::cout << std::left << std::setw(30) << nombre << std::right << std::fixed
+                  << std::setprecision(2)
+                  << std::setw(12) << std::chrono::duration<double, std::micro>(fin - inicio).count() / lecturas
+                  << "us" << std::setw(12) << despues.aciertos - antes.aciertos << "\n";
+    };
+    medir("sin caché", 0, 0);
+    medir("con caché", 64, 0);
+    medir("con caché, 1 escritura / 10", 64, 10);
+}
+
+// Backups sucesivos: el primero guarda los segmentos, los siguientes copian
+// solo el snapshot y la cola del log. Como referencia, la exportación
+// completa del historial en el formato de arreglo.
+void benchmark_backup(int registros) {
+    DirectorioTemporal dir("backup");
+    DatabaseJSON db(dir.archivo("usuarios.json"), dir.archivo("transacciones.json"));
+    db.configurar_durabilidad(ModoDurabilidad::NINGUNA);
+    db.configurar_archivado(0);
+
+    // Montos y fechas variados, para que los segmentos no se compriman a casi nada
+    std::mt19937 generador(42);
+    std::uniform_int_distribution<int> centavos(100, 10000000);
+    const int64_t inicio = 1735700000;
+    int siguiente = 1;
+    auto agregar = [&](int cantidad) {
+        std::vector<TransaccionDB> lote;
+        lote.reserve(cantidad);
+        for (int i = 0; i < cantidad; ++i, ++siguiente) {
+            lote.push_back(TransaccionDB{siguiente, "Cliente" + std::to_string(siguiente % 97),
+                                         "Cliente" + std::to_string(siguiente % 89),
+                                         centavos(generador) / 100.0, "TRANSFERENCIA", false,
+                                         marcas_tiempo::formatear(inicio + 7 * static_cast<int64_t>(siguiente))});
+        }
+        db.guardar_transacciones_lote(lote);
+    };
+    // El historial queda en 4 segmentos y una cola de 1000 en el log
+    for (int parte = 0; parte < 4; ++parte) {
+        agregar(registros / 4);
+        db.archivar_transacciones();
+    }
+    agregar(1000);
+
+    std::vector<std::pair<std::string, double>> tiempos;
+    auto medir = [&](const std::string& nombre, const std::function<bool()>& operacion) {
+        auto inicio = std::chrono::steady_clock::now();
+        if (!operacion()) std::cout << "  ERROR en " << nombre << "\n";
+        auto fin = std::chrono::steady_clock::now();
+        tiempos.emplace_back(nombre, std::chrono::duration<double, std::milli>(fin - inicio).count());
+    };
+    const std::string destino = dir.archivo("backups");
+    medir("exportación completa", [&] { return db.exportar_transacciones_json(dir.archivo("exportado.json")); });
+    medir("primer backup", [&] { return db.exportar_backup(destino); });
+    agregar(1000);
+    medir("backup (+1000 en el log)", [&] { return db.exportar_backup(destino); });
+    db.archivar_transacciones();
+    agregar(1000);
+    medir("backup (+1 segmento)", [&] { return db.exportar_backup(destino); });
+
+    std::cout << "\nHistorial de " << registros << " registros\n\n";
+    std::cout << std::left << std::setw(30) << "operación" << std::right << std::setw(12) << "tiempo" << "\n";
+    for (const auto& [nombre, ms] : tiempos) {
+        std::cout << std::left << std::setw(30) << nombre << std::right << std::fixed
+                  << std::setprecision(2) << std::setw(10) << ms << "ms\n";
+    }
+}
+
+void mostrar_uso() {
+    std::cout << "Uso: benchmark_db <prueba> [opciones]\n"
+              << "  commit [hilos=8] [commits_por_hilo=500]\n"
+              << "  parse [registros=1000000]\n"
+              << "  lectura [registros=200000]\n"
+              << "  archivo [registros=1000000]\n"
+              << "  carga [registros=2000000]\n"
+              << "  concurrencia [lectores=4] [segundos=3]\n"
+              << "  saldos [actualizaciones=2000]\n"
+              << "  reemplazo [usuarios=10000] [repeticiones=50]\n"
+              << "  caidas [rondas=20]\n"
+              << "  fragmentos [hilos=8] [operaciones_por_hilo=200]\n"
+              << "  compresion [registros=1000000]\n"
+              << "  periodo [registros=1000000]\n"
+              << "  serializar [registros=1000000]\n"
+              << "  existe [usuarios=100000] [consultas=10000000]\n"
+              << "  consulta [registros=1000000]\n"
+              << "  cache [lecturas=20000]\n"
+              << "  backup [registros=1000000]\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        mostrar_uso();
+        return 1;
+    }
+
+    std::string prueba = argv[1];
+    if (prueba == "commit") {
+        int hilos = argc > 2 ? std::stoi(argv[2]) : 8;
+        int commits = argc > 3 ? std::stoi(argv[3]) : 500;
+        benchmark_commit(hilos, commits);
+    } else if (prueba == "parse") {
+        int registros = argc > 2 ? std::stoi(argv[2]) : 1000000;
+        benchmark_parse(registros);
+    } else if (prueba == "lectura") {
+        int registros = argc > 2 ? std::stoi(argv[2]) : 200000;
+        benchmark_lectura(registros);
+    } else if (prueba == "archivo") {
+        int registros = argc > 2 ? std::stoi(argv[2]) : 1000000;
+        benchmark_archivo(registros);
+    } else if (prueba == "carga") {
+        int registros = argc > 2 ? std::stoi(argv[2]) : 2000000;
+        benchmark_carga(registros);
+    } else if (prueba == "concurrencia") {
+        int lectores = argc > 2 ? std::stoi(argv[2]) : 4;
+        int segundos = argc > 3 ? std::stoi(argv[3]) : 3;
+        benchmark_concurrencia(lectores, segundos);
+    } else if (prueba == "saldos") {
+        int actualizaciones = argc > 2 ? std::stoi(argv[2]) : 2000;
+        benchmark_saldos(actualizaciones);
+    } else if (prueba == "reemplazo") {
+        int usuarios = argc > 2 ? std::stoi(argv[2]) : 10000;
+        int repeticiones = argc > 3 ? std::stoi(argv[3]) : 50;
+        benchmark_reemplazo(usuarios, repeticiones);
+    } else if (prueba == "fragmentos") {
+        int hilos = argc > 2 ? std::stoi(argv[2]) : 8;
+        int operaciones = argc > 3 ? std::stoi(argv[3]) : 200;
+        benchmark_fragmentos(hilos, operaciones);
+    } else if (prueba == "compresion") {
+        int registros = argc > 2 ? std::stoi(argv[2]) : 1000000;
+        benchmark_compresion(registros);
+    } else if (prueba == "periodo") {
+        int registros = argc > 2 ? std::stoi(argv[2]) : 1000000;
+        benchmark_periodo(registros);
+    } else if (prueba == "serializar") {
+        int registros = argc > 2 ? std::stoi(argv[2]) : 1000000;
+        benchmark_serializar(registros);
+    } else if (prueba == "existe") {
+        int usuarios = argc > 2 ? std::stoi(argv[2]) : 100000;
+        int consultas = argc > 3 ? std::stoi(argv[3]) : 10000000;
+        benchmark_existe(usuarios, consultas);
+    } else if (prueba == "consulta") {
+        int registros = argc > 2 ? std::stoi(argv[2]) : 1000000;
+        benchmark_consulta(registros);
+    } else if (prueba == "cache") {
+        int lecturas = argc > 2 ? std::stoi(argv[2]) : 20000;
+        benchmark_cache(lecturas);
+    } else if (prueba == "backup") {
+        int registros = argc > 2 ? std::stoi(argv[2]) : 1000000;
+        benchmark_backup(registros);
+    } else if (prueba == "caidas") {
+#ifndef _WIN32
+        int rondas = argc > 2 ? std::stoi(argv[2]) : 20;
+        benchmark_caidas(rondas);
+#else
+        std::cout << "caidas necesita fork() (solo POSIX)\n";
+#endif
+    } else {
+        mostrar_uso();
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,332 @@
+// Importador masivo de usuarios y transacciones sobre
+// DatabaseJSON::guardar_usuarios_lote / guardar_transacciones_lote
+//
+// Compilar (o con ./compilar.sh):
+//   g++ -std=c++17 -O2 -pthread -Iinclude src/main_importador.cpp
+//       src/database_json.cpp src/escritor_log.cpp src/io_archivos.cpp
+//       src/parser_json.cpp src/archivo_mapeado.cpp src/segmento_columnar.cpp
+//       src/marcas_tiempo.cpp src/serializador_json.cpp src/filtro_bloom.cpp
+//       -o importador_db
+//
+// Uso:
+//   ./importador_db usuarios <entrada> [usuarios.json] [transacciones.json]
+//   ./importador_db transacciones <entrada> [usuarios.json] [transacciones.json]
+//
+// La entrada es CSV (.csv, con una fila de encabezado que nombra las
+// columnas) o JSONL (un objeto por línea); las columnas o claves son los
+// campos de UsuarioDB y TransaccionDB:
+//   usuarios:      nombre, cuenta_id, [saldo=0], [fecha_creacion=ahora]
+//   transacciones: usuario_origen, usuario_destino, monto, [id], [tipo=TRANSFERENCIA],
+//                  [es_sospechosa=false], [fecha=ahora]
+// Las transacciones sin id reciben ids nuevos, mayores que los ya guardados;
+// las que traen un id que no es mayor que todos los anteriores se saltan
+// como repetidas. Las columnas desconocidas se ignoran. En CSV los campos
+// pueden ir entre comillas ("" es una comilla), pero sin saltos de línea
+// dentro.
+
+#include "database_json.hpp"
+#include "archivo_mapeado.hpp"
+#include "parser_json.hpp"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+#include <unordered_map>
+#include <chrono>
+#include <ctime>
+#include <cstdlib>
+#include <cstdint>
+#include <charconv>
+
+namespace {
+
+// Filas por llamada a guardar_*_lote: acota la memoria del lote y deja
+// devolver al sistema las páginas ya leídas de la entrada. Cada lote de
+// usuarios publica una versión nueva de los índices (una copia de toda la
+// tabla), así que conviene que sean grandes.
+const size_t FILAS_POR_LOTE = 500000;
+const size_t ERRORES_MOSTRADOS = 10;
+
+// Campos asignados de cada fila (un juego de bits por tipo de registro)
+const unsigned CAMPO_NOMBRE       = 1u << 0;
+const unsigned CAMPO_CUENTA       = 1u << 1;
+const unsigned CAMPOS_USUARIO     = CAMPO_NOMBRE | CAMPO_CUENTA;
+const unsigned CAMPO_ORIGEN       = 1u << 0;
+const unsigned CAMPO_DESTINO      = 1u << 1;
+const unsigned CAMPO_MONTO        = 1u << 2;
+const unsigned CAMPO_ID           = 1u << 3;
+const unsigned CAMPOS_TRANSACCION = CAMPO_ORIGEN | CAMPO_DESTINO | CAMPO_MONTO;
+
+std::string fecha_actual() {
+    std::time_t ahora = std::time(nullptr);
+    char texto[20];
+    std::strftime(texto, sizeof(texto), "%Y-%m-%d %H:%M:%S", std::localtime(&ahora));
+    return texto;
+}
+
+bool leer_double(const std::string& texto, double& destino) {
+    if (texto.empty()) return false;
+    char* fin = nullptr;
+    destino = std::strtod(texto.c_str(), &fin);
+    return fin == texto.c_str() + texto.size();
+}
+
+bool leer_entero(const std::string& texto, int& destino) {
+    auto r = std::from_chars(texto.data(), texto.data() + texto.size(), destino);
+    return r.ec == std::errc() && r.ptr == texto.data() + texto.size();
+}
+
+bool leer_bool(const std::string& texto, bool& destino) {
+    if (texto == "true" || texto == "1") destino = true;
+    else if (texto == "false" || texto == "0" || texto.empty()) destino = false;
+    else return false;
+    return true;
+}
+
+// Asignan un campo ya convertido a texto; devuelven el bit del campo
+// obligatorio asignado (0 si es opcional o desconocido), o false en 'valido'
+// si el valor no es del tipo esperado
+unsigned asignar_campo(std::string_view clave, const std::string& valor, UsuarioDB& u, bool& valido) {
+    if (clave == "nombre") { u.nombre = valor; return CAMPO_NOMBRE; }
+    if (clave == "cuenta_id") { u.cuenta_id = valor; return CAMPO_CUENTA; }
+    if (clave == "saldo") valido &= leer_double(valor, u.saldo);
+    else if (clave == "fecha_creacion") u.fecha_creacion = valor;
+    return 0;
+}
+
+unsigned asignar_campo(std::string_view clave, const std::string& valor, TransaccionDB& t, bool& valido) {
+    if (clave == "usuario_origen") { t.usuario_origen = valor; return CAMPO_ORIGEN; }
+    if (clave == "usuario_destino") { t.usuario_destino = valor; return CAMPO_DESTINO; }
+    if (clave == "monto") { valido &= leer_double(valor, t.monto); return CAMPO_MONTO; }
+    if (clave == "id") {
+        // Vacío es lo mismo que no tenerlo
+        if (valor.empty()) return 0;
+        valido &= leer_entero(valor, t.id);
+        return CAMPO_ID;
+    }
+    if (clave == "tipo") t.tipo = valor;
+    else if (clave == "es_sospechosa") valido &= leer_bool(valor, t.es_sospechosa);
+    else if (clave == "fecha") t.fecha = valor;
+    return 0;
+}
+
+void valores_por_defecto(UsuarioDB& u, const std::string& ahora) {
+    u = UsuarioDB{"", "", 0.0, ahora};
+}
+
+void valores_por_defecto(TransaccionDB& t, const std::string& ahora) {
+    t = TransaccionDB{0, "", "", 0.0, "TRANSFERENCIA", false, ahora};
+}
+
+unsigned campos_obligatorios(const UsuarioDB&) { return CAMPOS_USUARIO; }
+unsigned campos_obligatorios(const TransaccionDB&) { return CAMPOS_TRANSACCION; }
+
+// Separa una línea CSV en 'campos'. false si una comilla queda sin cerrar.
+bool separar_csv(std::string_view linea, std::vector<std::string>& campos) {
+    campos.clear();
+    size_t i = 0;
+    while (true) {
+        campos.emplace_back();
+        std::string& campo = campos.back();
+        if (i < linea.size() && linea[i] == '"') {
+            ++i;
+            while (true) {
+                if (i >= linea.size()) return false;
+                if (linea[i] == '"') {
+                    if (i + 1 < linea.size() && linea[i + 1] == '"') {
+                        campo += '"';
+                        i += 2;
+                        continue;
+                    }
+                    ++i;
+                    break;
+                }
+                campo += linea[i++];
+            }
+            if (i < linea.size() && linea[i] != ',') return false;
+        } else {
+            size_t fin = linea.find(',', i);
+            if (fin == std::string_view::npos) fin = linea.size();
+            campo.assign(linea.substr(i, fin - i));
+            i = fin;
+        }
+        if (i >= linea.size()) return true;
+        ++i;  // la coma
+    }
+}
+
+struct Resultado {
+    size_t leidas = 0;
+    size_t guardadas = 0;
+    size_t con_error = 0;
+};
+
+// Recorre la entrada línea por línea, arma lotes de FILAS_POR_LOTE registros
+// y se los pasa a 'guardar', que devuelve cuántos quedaron guardados
+template <typename Registro, typename Guardar>
+Resultado importar(const ArchivoMapeado& entrada, bool es_csv, Guardar&& guardar) {
+    Resultado resultado;
+    const std::string ahora = fecha_actual();
+    std::string_view texto = entrada.contenido();
+    // Marca de orden de bytes de UTF-8 (la agregan algunas planillas)
+    if (texto.substr(0, 3) == "\xEF\xBB\xBF") texto.remove_prefix(3);
+
+    std::vector<Registro> lote;
+    lote.reserve(FILAS_POR_LOTE);
+    std::vector<std::string> columnas;
+    std::vector<std::string> campos;
+    std::string valor;
+    bool con_encabezado = !es_csv;
+    size_t numero_linea = 0;
+
+    auto error = [&](const char* motivo) {
+        if (resultado.con_error++ < ERRORES_MOSTRADOS) {
+            std::cerr << "Línea " << numero_linea << ": " << motivo << "\n";
+        }
+    };
+    auto guardar_lote = [&](size_t hasta) {
+        resultado.guardadas += guardar(lote);
+        lote.clear();
+        entrada.descartar_hasta(static_cast<size_t>(texto.data() - entrada.contenido().data()) + hasta);
+    };
+
+    size_t inicio = 0;
+    while (inicio < texto.size()) {
+        size_t fin = texto.find('\n', inicio);
+        if (fin == std::string_view::npos) fin = texto.size();
+        std::string_view linea = texto.substr(inicio, fin - inicio);
+        inicio = fin + 1;
+        ++numero_linea;
+        if (!linea.empty() && linea.back() == '\r') linea.remove_suffix(1);
+        if (linea.empty()) continue;
+
+        if (!con_encabezado) {
+            if (!separar_csv(linea, columnas)) {
+                resultado.leidas++;
+                error("encabezado CSV mal formado");
+                return resultado;
+            }
+            con_encabezado = true;
+            continue;
+        }
+
+        resultado.leidas++;
+        Registro registro;
+        valores_por_defecto(registro, ahora);
+        unsigned asignados = 0;
+        bool valido = true;
+        if (es_csv) {
+            if (!separar_csv(linea, campos) || campos.size() != columnas.size()) {
+                error("cantidad de columnas distinta al encabezado");
+                continue;
+            }
+            for (size_t c = 0; c < columnas.size(); ++c) {
+                asignados |= asignar_campo(columnas[c], campos[c], registro, valido);
+            }
+        } else {
+            LectorJSON lector(linea);
+            bool leido = lector.recorrer_objeto([&](std::string_view clave, const ValorJSON& v) {
+                if (v.tipo == ValorJSON::Tipo::CADENA) valido &= v.como_cadena(valor);
+                else valor.assign(v.texto);
+                asignados |= asignar_campo(clave, valor, registro, valido);
+            });
+            if (!leido || !lector.al_final()) {
+                error("JSON mal formado");
+                continue;
+            }
+        }
+        if (!valido) {
+            error("valor con tipo inválido");
+            continue;
+        }
+        if ((asignados & campos_obligatorios(registro)) != campos_obligatorios(registro)) {
+            error("faltan campos obligatorios");
+            continue;
+        }
+        if constexpr (std::is_same_v<Registro, TransaccionDB>) {
+            if (!(asignados & CAMPO_ID)) registro.id = 0;
+        }
+
+        lote.push_back(std::move(registro));
+        if (lote.size() == FILAS_POR_LOTE) guardar_lote(std::min(inicio, texto.size()));
+    }
+    if (!lote.empty()) guardar_lote(texto.size());
+    return resultado;
+}
+
+bool termina_en(const std::string& texto, std::string_view sufijo) {
+    return texto.size() >= sufijo.size() &&
+           texto.compare(texto.size() - sufijo.size(), sufijo.size(), sufijo) == 0;
+}
+
+void mostrar_uso() {
+    std::cout << "Uso: importador_db <usuarios|transacciones> <entrada.csv|entrada.jsonl>"
+                 " [usuarios.json] [transacciones.json]\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        mostrar_uso();
+        return 1;
+    }
+
+    std::string tipo = argv[1];
+    std::string ruta_entrada = argv[2];
+    if (tipo != "usuarios" && tipo != "transacciones") {
+        mostrar_uso();
+        return 1;
+    }
+
+    ArchivoMapeado entrada(ruta_entrada);
+    if (!entrada.esta_abierto()) {
+        std::cerr << "No se pudo abrir " << ruta_entrada << "\n";
+        return 1;
+    }
+    // Por extensión; si no la dice, JSONL cuando empieza con un objeto
+    bool es_csv = termina_en(ruta_entrada, ".csv");
+    if (!es_csv && !termina_en(ruta_entrada, ".jsonl") && !termina_en(ruta_entrada, ".ndjson")) {
+        std::string_view contenido = entrada.contenido();
+        size_t primero = contenido.find_first_not_of(" \t\r\n");
+        es_csv = primero == std::string_view::npos || contenido[primero] != '{';
+    }
+
+    DatabaseJSON db(argc > 3 ? argv[3] : "usuarios.json",
+                    argc > 4 ? argv[4] : "transacciones.json");
+
+    // Un solo checkpoint al final: los periódicos reescribirían el snapshot
+    // completo entre lote y lote
+    db.configurar_checkpoint(std::chrono::hours(24), SIZE_MAX);
+
+    auto inicio = std::chrono::steady_clock::now();
+    Resultado resultado;
+    if (tipo == "usuarios") {
+        resultado = importar<UsuarioDB>(entrada, es_csv, [&](const std::vector<UsuarioDB>& lote) {
+            return db.guardar_usuarios_lote(lote);
+        });
+    } else {
+        resultado = importar<TransaccionDB>(entrada, es_csv, [&](const std::vector<TransaccionDB>& lote) {
+            // Las filas sin id llegan con id 0 y toman ids de la secuencia
+            return db.guardar_transacciones_lote(lote);
+        });
+    }
+    // El snapshot de usuarios incorpora las altas ahora y no al próximo arranque
+    db.checkpoint();
+    auto fin = std::chrono::steady_clock::now();
+
+    double segundos = std::chrono::duration<double>(fin - inicio).count();
+    std::cout << "Filas leídas:          " << resultado.leidas << "\n"
+              << "Guardadas:             " << resultado.guardadas << "\n"
+              << "Existentes o repetidas: "
+              << resultado.leidas - resultado.con_error - resultado.guardadas << "\n"
+              << "Con error:             " << resultado.con_error << "\n"
+              << std::fixed << std::setprecision(2)
+              << "Tiempo:                " << segundos << " s ("
+              << std::setprecision(0) << (segundos > 0 ? resultado.guardadas / segundos : 0)
+              << " filas/s)\n";
+    return resultado.con_error > 0 ? 2 : 0;
+}
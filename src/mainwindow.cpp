@@ -433,11 +433,7 @@ void MainWindow::enviar_transaccion() {
     bool exito = monitor->transferir(usuario_origen.cuenta_id, usuario_destino.cuenta_id, monto);
 
     if (exito) {
-        // 6.1. Actualizar saldos
-        db->actualizar_saldo(usuario_origen.nombre, usuario_origen.saldo - monto);
-        db->actualizar_saldo(usuario_destino.nombre, usuario_destino.saldo + monto);
-
-        // 6.2. Guardar transacción
+        // 6.1. Registrar saldos y transacción en un único commit atómico
         TransaccionDB tdb;
         tdb.id = t.id;
         tdb.usuario_origen = t.cliente_id;
@@ -446,7 +442,14 @@ void MainWindow::enviar_transaccion() {
         tdb.tipo = t.tipo;
         tdb.es_sospechosa = t.es_sospechosa;
         tdb.fecha = QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss").toStdString();
-        db->guardar_transaccion(tdb);
+
+        if (!db->commit_transferencia(usuario_origen.nombre, usuario_destino.nombre, monto, tdb)) {
+            // Deshacer el movimiento en el monitor para no divergir de la BD
+            monitor->transferir(usuario_destino.cuenta_id, usuario_origen.cuenta_id, monto);
+            log_mensaje("X Error al persistir la transferencia en la base de datos.", "error");
+            QMessageBox::critical(this, "Error", "No se pudo guardar la transacción.");
+            return;
+        }
 
         // 6.3. Actualizar contadores
         contador_transacciones++;
@@ -781,9 +784,6 @@ void MainWindow::resolver_deadlock_demo() {
             bool exito1 = monitor->transferir(cuenta_A, cuenta_B, monto_A_a_B);
 
             if (exito1) {
-                db->actualizar_saldo(usuario_A.nombre, saldo_antes_A - monto_A_a_B);
-                db->actualizar_saldo(usuario_B.nombre, saldo_antes_B + monto_A_a_B);
-
                 TransaccionDB tdb1;
                 tdb1.id = db->obtener_siguiente_id_transaccion();
                 tdb1.usuario_origen = usuario_A.nombre;
@@ -792,13 +792,17 @@ void MainWindow::resolver_deadlock_demo() {
                 tdb1.tipo = "TRANSFERENCIA_DEADLOCK";
                 tdb1.es_sospechosa = false;
                 tdb1.fecha = QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss").toStdString();
-                db->guardar_transaccion(tdb1);
-
-                contador_transacciones++;
-                transacciones_aprobadas++;
-                monto_total_procesado += monto_A_a_B;
+                if (!db->commit_transferencia(usuario_A.nombre, usuario_B.nombre, monto_A_a_B, tdb1)) {
+                    // La BD rechazó el movimiento: deshacerlo en el monitor
+                    monitor->transferir(cuenta_B, cuenta_A, monto_A_a_B);
+                    log_demo("   X Error al persistir en la base de datos (revertida)", "error");
+                } else {
+                    contador_transacciones++;
+                    transacciones_aprobadas++;
+                    monto_total_procesado += monto_A_a_B;
 
-                log_demo("   ✔ Completada", "success");
+                    log_demo("   ✔ Completada", "success");
+                }
             }
 
             std::this_thread::sleep_for(std::chrono::milliseconds(400));
@@ -815,9 +819,6 @@ void MainWindow::resolver_deadlock_demo() {
             bool exito2 = monitor->transferir(cuenta_B, cuenta_A, monto_B_a_A);
 
             if (exito2) {
-                db->actualizar_saldo(usuario_B_intermedio.nombre, usuario_B_intermedio.saldo - monto_B_a_A);
-                db->actualizar_saldo(usuario_A_intermedio.nombre, usuario_A_intermedio.saldo + monto_B_a_A);
-
                 TransaccionDB tdb2;
                 tdb2.id = db->obtener_siguiente_id_transaccion();
                 tdb2.usuario_origen = usuario_B.nombre;
@@ -826,13 +827,17 @@ void MainWindow::resolver_deadlock_demo() {
                 tdb2.tipo = "TRANSFERENCIA_DEADLOCK";
                 tdb2.es_sospechosa = false;
                 tdb2.fecha = QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss").toStdString();
-                db->guardar_transaccion(tdb2);
-
-                contador_transacciones++;
-                transacciones_aprobadas++;
-                monto_total_procesado += monto_B_a_A;
+                if (!db->commit_transferencia(usuario_B_intermedio.nombre, usuario_A_intermedio.nombre, monto_B_a_A, tdb2)) {
+                    // La BD rechazó el movimiento: deshacerlo en el monitor
+                    monitor->transferir(cuenta_A, cuenta_B, monto_B_a_A);
+                    log_demo("   X Error al persistir en la base de datos (revertida)", "error");
+                } else {
+                    contador_transacciones++;
+                    transacciones_aprobadas++;
+                    monto_total_procesado += monto_B_a_A;
 
-                log_demo("   ✔ Completada", "success");
+                    log_demo("   ✔ Completada", "success");
+                }
             }
 
             std::this_thread::sleep_for(std::chrono::milliseconds(400));
@@ -1159,7 +1164,8 @@ void MainWindow::demostrar_lectores_escritores() {
 
                     std::this_thread::sleep_for(std::chrono::milliseconds(600));
 
-                    auto transacciones = db->cargar_transacciones(100);
+                    // Solo se cuentan campos: basta con las vistas sobre el log mapeado
+                    auto transacciones = db->mapear_transacciones(100);
 
                     int total = transacciones.size();
                     int aprobadas = 0;
@@ -1265,7 +1271,8 @@ void MainWindow::demostrar_lectores_escritores() {
 
                     std::this_thread::sleep_for(std::chrono::milliseconds(600));
 
-                    auto transacciones = db->cargar_transacciones(100);
+                    // Solo se cuentan campos: basta con las vistas sobre el log mapeado
+                    auto transacciones = db->mapear_transacciones(100);
 
                     int total = transacciones.size();
                     int sospechosas = 0;
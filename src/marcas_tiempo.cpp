@@ -0,0 +1,85 @@
+#include "marcas_tiempo.hpp"
+#include <cstring>
+
+namespace marcas_tiempo {
+
+namespace {
+
+// Días desde 1970-01-01 en el calendario gregoriano proléptico
+int64_t dias_desde_civil(int64_t anio, unsigned mes, unsigned dia) {
+    anio -= mes <= 2;
+    int64_t era = (anio >= 0 ? anio : anio - 399) / 400;
+    unsigned anio_era = static_cast<unsigned>(anio - era * 400);
+    unsigned dia_anio = (153 * (mes > 2 ? mes - 3 : mes + 9) + 2) / 5 + dia - 1;
+    unsigned dia_era = anio_era * 365 + anio_era / 4 - anio_era / 100 + dia_anio;
+    return era * 146097 + static_cast<int64_t>(dia_era) - 719468;
+}
+
+void civil_desde_dias(int64_t dias, int64_t& anio, unsigned& mes, unsigned& dia) {
+    dias += 719468;
+    int64_t era = (dias >= 0 ? dias : dias - 146096) / 146097;
+    unsigned dia_era = static_cast<unsigned>(dias - era * 146097);
+    unsigned anio_era = (dia_era - dia_era / 1460 + dia_era / 36524 - dia_era / 146096) / 365;
+    unsigned dia_anio = dia_era - (365 * anio_era + anio_era / 4 - anio_era / 100);
+    unsigned mp = (5 * dia_anio + 2) / 153;
+    dia = dia_anio - (153 * mp + 2) / 5 + 1;
+    mes = mp < 10 ? mp + 3 : mp - 9;
+    anio = static_cast<int64_t>(anio_era) + era * 400 + (mes <= 2);
+}
+
+void escribir_digitos(char* destino, uint64_t valor, int cifras) {
+    for (int i = cifras - 1; i >= 0; --i) {
+        destino[i] = static_cast<char>('0' + valor % 10);
+        valor /= 10;
+    }
+}
+
+} // namespace
+
+// Se llama una vez por registro decodificado: se arma a mano, sin pasar por
+// snprintf
+void formatear(int64_t segundos, char* destino) {
+    int64_t dias = (segundos >= 0 ? segundos : segundos - 86399) / 86400;
+    uint64_t resto = static_cast<uint64_t>(segundos - dias * 86400);
+    int64_t anio;
+    unsigned mes, dia;
+    civil_desde_dias(dias, anio, mes, dia);
+    std::memcpy(destino, "0000-00-00 00:00:00", LARGO_FECHA);
+    escribir_digitos(destino, static_cast<uint64_t>(anio), 4);
+    escribir_digitos(destino + 5, mes, 2);
+    escribir_digitos(destino + 8, dia, 2);
+    escribir_digitos(destino + 11, resto / 3600, 2);
+    escribir_digitos(destino + 14, resto / 60 % 60, 2);
+    escribir_digitos(destino + 17, resto % 60, 2);
+}
+
+bool a_segundos(std::string_view fecha, int64_t& segundos) {
+    static const char patron[] = "0000-00-00 00:00:00";
+    if (fecha.size() != LARGO_FECHA) return false;
+    for (size_t i = 0; i < LARGO_FECHA; ++i) {
+        bool digito = fecha[i] >= '0' && fecha[i] <= '9';
+        if (patron[i] == '0' ? !digito : fecha[i] != patron[i]) return false;
+    }
+    auto numero = [&](size_t desde, size_t largo) {
+        unsigned valor = 0;
+        for (size_t i = desde; i < desde + largo; ++i) valor = valor * 10 + (fecha[i] - '0');
+        return valor;
+    };
+    unsigned mes = numero(5, 2);
+    unsigned dia = numero(8, 2);
+    if (mes < 1 || mes > 12 || dia < 1 || dia > 31) return false;
+    segundos = dias_desde_civil(numero(0, 4), mes, dia) * 86400 +
+               numero(11, 2) * 3600 + numero(14, 2) * 60 + numero(17, 2);
+
+    char reescrita[LARGO_FECHA];
+    formatear(segundos, reescrita);
+    return fecha == std::string_view(reescrita, LARGO_FECHA);
+}
+
+std::string formatear(int64_t segundos) {
+    std::string fecha(LARGO_FECHA, '0');
+    formatear(segundos, &fecha[0]);
+    return fecha;
+}
+
+} // namespace marcas_tiempo
@@ -0,0 +1,240 @@
+#include "parser_json.hpp"
+#include <charconv>
+#include <locale>
+#include <sstream>
+
+namespace {
+
+int valor_hex(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool leer_hex4(std::string_view texto, size_t pos, uint32_t& codigo) {
+    if (pos + 4 > texto.size()) return false;
+    codigo = 0;
+    for (size_t i = pos; i < pos + 4; ++i) {
+        int d = valor_hex(texto[i]);
+        if (d < 0) return false;
+        codigo = (codigo << 4) | static_cast<uint32_t>(d);
+    }
+    return true;
+}
+
+void agregar_utf8(std::string& destino, uint32_t codigo) {
+    if (codigo < 0x80) {
+        destino += static_cast<char>(codigo);
+    } else if (codigo < 0x800) {
+        destino += static_cast<char>(0xC0 | (codigo >> 6));
+        destino += static_cast<char>(0x80 | (codigo & 0x3F));
+    } else if (codigo < 0x10000) {
+        destino += static_cast<char>(0xE0 | (codigo >> 12));
+        destino += static_cast<char>(0x80 | ((codigo >> 6) & 0x3F));
+        destino += static_cast<char>(0x80 | (codigo & 0x3F));
+    } else {
+        destino += static_cast<char>(0xF0 | (codigo >> 18));
+        destino += static_cast<char>(0x80 | ((codigo >> 12) & 0x3F));
+        destino += static_cast<char>(0x80 | ((codigo >> 6) & 0x3F));
+        destino += static_cast<char>(0x80 | (codigo & 0x3F));
+    }
+}
+
+template <typename T>
+bool convertir_numero(const ValorJSON& valor, T& destino) {
+    if (valor.tipo != ValorJSON::Tipo::NUMERO) return false;
+#if !defined(__cpp_lib_to_chars)
+    // from_chars para double llegó en GCC 11 / libc++ 20: antes se lee con
+    // un stream en el locale "C", no con strtod, que sigue al locale global
+    // (con coma decimal cortaría "12.50" en 12)
+    if constexpr (std::is_floating_point_v<T>) {
+        std::istringstream entrada{std::string(valor.texto)};
+        entrada.imbue(std::locale::classic());
+        return static_cast<bool>(entrada >> destino) &&
+               entrada.peek() == std::char_traits<char>::eof();
+    } else
+#endif
+    {
+        const char* fin = valor.texto.data() + valor.texto.size();
+        auto resultado = std::from_chars(valor.texto.data(), fin, destino);
+        return resultado.ec == std::errc() && resultado.ptr == fin;
+    }
+}
+
+} // namespace
+
+bool ValorJSON::como_cadena(std::string& destino) const {
+    if (tipo != Tipo::CADENA) return false;
+    if (!con_escapes) {
+        destino.assign(texto.data(), texto.size());
+        return true;
+    }
+    
+    destino.clear();
+    destino.reserve(texto.size());
+    for (size_t i = 0; i < texto.size(); ++i) {
+        char c = texto[i];
+        if (c != '\\') {
+            destino += c;
+            continue;
+        }
+        if (++i >= texto.size()) return false;
+        switch (texto[i]) {
+            case 'n': destino += '\n'; break;
+            case 't': destino += '\t'; break;
+            case 'r': destino += '\r'; break;
+            case 'b': destino += '\b'; break;
+            case 'f': destino += '\f'; break;
+            case 'u': {
+                uint32_t codigo = 0;
+                if (!leer_hex4(texto, i + 1, codigo)) return false;
+                i += 4;
+                // Par sustituto UTF-16 para caracteres fuera del plano básico
+                uint32_t bajo = 0;
+                if (codigo >= 0xD800 && codigo <= 0xDBFF && i + 6 < texto.size() &&
+                    texto[i + 1] == '\\' && texto[i + 2] == 'u' && leer_hex4(texto, i + 3, bajo) &&
+                    bajo >= 0xDC00 && bajo <= 0xDFFF) {
+                    codigo = 0x10000 + ((codigo - 0xD800) << 10) + (bajo - 0xDC00);
+                    i += 6;
+                }
+                agregar_utf8(destino, codigo);
+                break;
+            }
+            default:
+                // \" \\ \/ y cualquier otro carácter escapado se copian tal cual
+                destino += texto[i];
+                break;
+        }
+    }
+    return true;
+}
+
+bool ValorJSON::como_double(double& destino) const {
+    return convertir_numero(*this, destino);
+}
+
+bool ValorJSON::como_entero(int& destino) const {
+    return convertir_numero(*this, destino);
+}
+
+bool ValorJSON::como_entero(uint64_t& destino) const {
+    return convertir_numero(*this, destino);
+}
+
+bool ValorJSON::como_bool(bool& destino) const {
+    if (tipo != Tipo::BOOLEANO) return false;
+    destino = (texto == "true");
+    return true;
+}
+
+void LectorJSON::saltar_espacios() {
+    while (pos < texto.size()) {
+        char c = texto[pos];
+        if (c != ' ' && c != '\n' && c != '\r' && c != '\t') break;
+        ++pos;
+    }
+}
+
+bool LectorJSON::consumir(char c) {
+    saltar_espacios();
+    if (pos < texto.size() && texto[pos] == c) {
+        ++pos;
+        return true;
+    }
+    return false;
+}
+
+bool LectorJSON::al_final() {
+    saltar_espacios();
+    return pos >= texto.size();
+}
+
+bool LectorJSON::leer_cadena(std::string_view& contenido, bool& con_escapes) {
+    if (pos >= texto.size() || texto[pos] != '"') return false;
+    size_t inicio = ++pos;
+    con_escapes = false;
+    
+    while (pos < texto.size()) {
+        char c = texto[pos];
+        if (c == '"') {
+            contenido = texto.substr(inicio, pos - inicio);
+            ++pos;
+            return true;
+        }
+        if (c == '\\') {
+            con_escapes = true;
+            pos += 2;
+            continue;
+        }
+        ++pos;
+    }
+    return false;
+}
+
+bool LectorJSON::saltar_compuesto() {
+    // Se llama con pos sobre '{' o '['; solo hace falta equilibrar
+    // los delimitadores, sin interpretar lo que hay dentro
+    int profundidad = 0;
+    std::string_view cadena;
+    bool escapes = false;
+    while (pos < texto.size()) {
+        char c = texto[pos];
+        if (c == '"') {
+            if (!leer_cadena(cadena, escapes)) return false;
+            continue;
+        }
+        if (c == '{' || c == '[') {
+            profundidad++;
+        } else if (c == '}' || c == ']') {
+            if (--profundidad == 0) {
+                ++pos;
+                return true;
+            }
+        }
+        ++pos;
+    }
+    return false;
+}
+
+bool LectorJSON::leer_valor(ValorJSON& valor) {
+    saltar_espacios();
+    if (pos >= texto.size()) return false;
+    
+    size_t inicio = pos;
+    valor.con_escapes = false;
+    char c = texto[pos];
+    
+    if (c == '"') {
+        valor.tipo = ValorJSON::Tipo::CADENA;
+        return leer_cadena(valor.texto, valor.con_escapes);
+    }
+    if (c == '{' || c == '[') {
+        valor.tipo = ValorJSON::Tipo::COMPUESTO;
+        if (!saltar_compuesto()) return false;
+        valor.texto = texto.substr(inicio, pos - inicio);
+        return true;
+    }
+    
+    auto literal = [&](std::string_view palabra, ValorJSON::Tipo tipo) {
+        if (texto.substr(pos, palabra.size()) != palabra) return false;
+        pos += palabra.size();
+        valor.tipo = tipo;
+        valor.texto = palabra;
+        return true;
+    };
+    if (c == 't') return literal("true", ValorJSON::Tipo::BOOLEANO);
+    if (c == 'f') return literal("false", ValorJSON::Tipo::BOOLEANO);
+    if (c == 'n') return literal("null", ValorJSON::Tipo::NULO);
+    
+    // Número: se delimita aquí y se valida al convertirlo con from_chars
+    while (pos < texto.size()) {
+        c = texto[pos];
+        if ((c < '0' || c > '9') && c != '-' && c != '+' && c != '.' && c != 'e' && c != 'E') break;
+        ++pos;
+    }
+    if (pos == inicio) return false;
+    valor.tipo = ValorJSON::Tipo::NUMERO;
+    valor.texto = texto.substr(inicio, pos - inicio);
+    return true;
+}
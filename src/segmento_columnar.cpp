@@ -0,0 +1,772 @@
+#include "segmento_columnar.hpp"
+#include "io_archivos.hpp"
+#include "marcas_tiempo.hpp"
+#include <algorithm>
+#include <atomic>
+#include <list>
+#include <unordered_map>
+#include <cmath>
+#include <cstring>
+#include <climits>
+#include <functional>
+
+namespace {
+
+// Formato (enteros fijos en little-endian):
+//   "SEGCOL03" | registros u64 | id máximo u32 | largo del prefijo u64 |
+//   CRC del prefijo u32 | CRC del inicio del prefijo u32 | filas por bloque u32 |
+//   diccionario: largo u64 + paquete | índice: largo u64 + bytes |
+//   CRC de todo lo anterior u32 | bloques, uno tras otro
+// El índice tiene, por bloque y en varint: filas, id mínimo y máximo
+// (zigzag), fecha mínima y máxima en segundos (zigzag; la mínima mayor que
+// la máxima si ninguna fecha tiene el formato canónico), largo del paquete
+// y su CRC. Un paquete es un byte de método (crudo o LZ), el largo
+// descomprimido en varint y los datos. Descomprimido,
+// un bloque son 7 columnas (largo u64 + bytes): ids, montos, fechas,
+// orígenes, destinos, tipos y sospechosas, con los deltas desde cero.
+const char MAGICO[8] = {'S', 'E', 'G', 'C', 'O', 'L', '0', '3'};
+const size_t LARGO_CABECERA = 8 + 8 + 4 + 8 + 4 + 4 + 4;
+const size_t BYTES_INICIO = 4096;      // Comprobación rápida del prefijo
+const size_t LARGO_FECHA = marcas_tiempo::LARGO_FECHA;
+const int64_t SIN_FECHA = marcas_tiempo::SIN_FECHA;
+const size_t COLUMNAS_BLOQUE = 7;
+
+enum : uint8_t { FECHAS_SEGUNDOS = 0, FECHAS_DICCIONARIO = 1 };
+enum : uint8_t { PAQUETE_CRUDO = 0, PAQUETE_LZ = 1 };
+
+void escribir_fijo(std::string& destino, uint64_t valor, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        destino += static_cast<char>((valor >> (8 * i)) & 0xFFu);
+    }
+}
+
+uint64_t leer_fijo(const char* datos, int bytes) {
+    uint64_t valor = 0;
+    for (int i = 0; i < bytes; ++i) {
+        valor |= static_cast<uint64_t>(static_cast<unsigned char>(datos[i])) << (8 * i);
+    }
+    return valor;
+}
+
+void escribir_varint(std::string& destino, uint64_t valor) {
+    while (valor >= 0x80) {
+        destino += static_cast<char>((valor & 0x7Fu) | 0x80u);
+        valor >>= 7;
+    }
+    destino += static_cast<char>(valor);
+}
+
+uint64_t zigzag(int64_t valor) {
+    return (static_cast<uint64_t>(valor) << 1) ^ static_cast<uint64_t>(valor >> 63);
+}
+
+int64_t des_zigzag(uint64_t valor) {
+    return static_cast<int64_t>(valor >> 1) ^ -static_cast<int64_t>(valor & 1);
+}
+
+// Lectura secuencial con control de límites sobre una columna
+struct LectorBytes {
+    const char* actual;
+    const char* fin;
+
+    bool varint(uint64_t& valor) {
+        valor = 0;
+        for (int desplazamiento = 0; desplazamiento < 64; desplazamiento += 7) {
+            if (actual == fin) return false;
+            uint8_t byte = static_cast<uint8_t>(*actual++);
+            valor |= static_cast<uint64_t>(byte & 0x7Fu) << desplazamiento;
+            if (!(byte & 0x80u)) return true;
+        }
+        return false;
+    }
+
+    bool delta(int64_t& anterior) {
+        uint64_t valor;
+        if (!varint(valor)) return false;
+        anterior += des_zigzag(valor);
+        return true;
+    }
+
+    bool bloque(std::string_view& columna) {
+        if (fin - actual < 8) return false;
+        uint64_t largo = leer_fijo(actual, 8);
+        actual += 8;
+        if (static_cast<uint64_t>(fin - actual) < largo) return false;
+        columna = std::string_view(actual, static_cast<size_t>(largo));
+        actual += largo;
+        return true;
+    }
+};
+
+// Compresor LZ: secuencias de [literales en varint | literales |
+// largo de la coincidencia - MINIMO_COINCIDENCIA en varint | distancia en
+// varint], y al final una de solo literales. Las coincidencias se buscan con
+// una tabla hash de 4 bytes, sin cadenas: lo que se repite en las columnas
+// (deltas iguales, índices cercanos, nombres con el mismo prefijo) aparece
+// muy cerca.
+const size_t MINIMO_COINCIDENCIA = 4;
+const unsigned BITS_TABLA = 14;
+
+uint32_t leer_32(const char* datos) {
+    uint32_t valor;
+    std::memcpy(&valor, datos, sizeof(valor));
+    return valor;
+}
+
+void comprimir_lz(std::string_view entrada, std::string& salida) {
+    std::vector<uint32_t> tabla(size_t(1) << BITS_TABLA, 0);   // Posición + 1
+    const size_t n = entrada.size();
+    size_t ancla = 0;
+    size_t i = 0;
+    while (i + MINIMO_COINCIDENCIA <= n) {
+        uint32_t secuencia = leer_32(entrada.data() + i);
+        uint32_t hash = (secuencia * 2654435761u) >> (32 - BITS_TABLA);
+        size_t candidato = tabla[hash];
+        tabla[hash] = static_cast<uint32_t>(i + 1);
+        if (candidato == 0 || leer_32(entrada.data() + candidato - 1) != secuencia) {
+            i++;
+            continue;
+        }
+
+        size_t origen = candidato - 1;
+        size_t largo = MINIMO_COINCIDENCIA;
+        while (i + largo < n && entrada[origen + largo] == entrada[i + largo]) largo++;
+        escribir_varint(salida, i - ancla);
+        salida.append(entrada.data() + ancla, i - ancla);
+        escribir_varint(salida, largo - MINIMO_COINCIDENCIA);
+        escribir_varint(salida, i - origen);
+        i += largo;
+        ancla = i;
+    }
+    escribir_varint(salida, n - ancla);
+    salida.append(entrada.data() + ancla, n - ancla);
+}
+
+bool descomprimir_lz(std::string_view entrada, size_t largo, std::string& salida) {
+    salida.resize(largo);
+    char* destino = salida.empty() ? nullptr : &salida[0];
+    size_t escrito = 0;
+    LectorBytes lector{entrada.data(), entrada.data() + entrada.size()};
+    while (true) {
+        uint64_t literales = 0;
+        if (!lector.varint(literales) || static_cast<uint64_t>(lector.fin - lector.actual) < literales ||
+            literales > largo - escrito) {
+            return false;
+        }
+        std::memcpy(destino + escrito, lector.actual, static_cast<size_t>(literales));
+        lector.actual += literales;
+        escrito += static_cast<size_t>(literales);
+        if (escrito == largo) return lector.actual == lector.fin;
+
+        uint64_t extra = 0, distancia = 0;
+        if (!lector.varint(extra) || !lector.varint(distancia) || distancia == 0 ||
+            distancia > escrito || extra > largo - escrito - MINIMO_COINCIDENCIA) {
+            return false;
+        }
+        size_t copia = static_cast<size_t>(extra) + MINIMO_COINCIDENCIA;
+        const char* origen = destino + escrito - distancia;
+        if (distancia >= copia) {
+            std::memcpy(destino + escrito, origen, copia);
+        } else {
+            // Se solapa con lo que se está escribiendo: repite un patrón corto
+            for (size_t k = 0; k < copia; ++k) destino[escrito + k] = origen[k];
+        }
+        escrito += copia;
+    }
+}
+
+// Paquete: método, largo descomprimido y datos. Si LZ no achica, va crudo.
+void empaquetar(std::string_view crudo, bool comprimir, std::string& destino) {
+    std::string comprimido;
+    if (comprimir) comprimir_lz(crudo, comprimido);
+    bool usar_lz = comprimir && comprimido.size() < crudo.size();
+    destino += static_cast<char>(usar_lz ? PAQUETE_LZ : PAQUETE_CRUDO);
+    escribir_varint(destino, crudo.size());
+    if (usar_lz) destino += comprimido;
+    else destino.append(crudo.data(), crudo.size());
+}
+
+// 'crudo' apunta a 'almacen' o, si el paquete no está comprimido, al paquete
+bool desempaquetar(std::string_view paquete, std::string& almacen, std::string_view& crudo) {
+    if (paquete.empty()) return false;
+    uint8_t metodo = static_cast<uint8_t>(paquete[0]);
+    LectorBytes lector{paquete.data() + 1, paquete.data() + paquete.size()};
+    uint64_t largo = 0;
+    if (!lector.varint(largo)) return false;
+    std::string_view datos(lector.actual, static_cast<size_t>(lector.fin - lector.actual));
+    if (metodo == PAQUETE_CRUDO) {
+        if (datos.size() != largo) return false;
+        crudo = datos;
+        return true;
+    }
+    if (metodo != PAQUETE_LZ || !descomprimir_lz(datos, static_cast<size_t>(largo), almacen)) {
+        return false;
+    }
+    crudo = almacen;
+    return true;
+}
+
+// Columnas de las filas [desde, hasta) de un bloque, sin comprimir,
+// y el rango de sus fechas canónicas
+std::string codificar_bloque(const std::vector<TransaccionVista>& registros, size_t desde, size_t hasta,
+                             const std::function<uint32_t(std::string_view)>& indice,
+                             int64_t& segundos_min, int64_t& segundos_max) {
+    std::string ids, montos, fechas, origenes, destinos, tipos;
+    std::string sospechosas((hasta - desde + 7) / 8, '\0');
+    int64_t id_anterior = 0, centavos_anterior = 0, segundos_anterior = 0;
+    bool fechas_canonicas = true;
+    segundos_min = INT64_MAX;
+    segundos_max = INT64_MIN;
+
+    fechas += static_cast<char>(FECHAS_SEGUNDOS);
+    for (size_t i = desde; i < hasta; ++i) {
+        const TransaccionVista& t = registros[i];
+        escribir_varint(ids, zigzag(t.id - id_anterior));
+        id_anterior = t.id;
+
+        // El log guarda los montos con dos decimales: en centavos son exactos
+        int64_t centavos = std::llround(t.monto * 100.0);
+        escribir_varint(montos, zigzag(centavos - centavos_anterior));
+        centavos_anterior = centavos;
+
+        int64_t segundos = 0;
+        if (marcas_tiempo::a_segundos(t.fecha, segundos)) {
+            segundos_min = std::min(segundos_min, segundos);
+            segundos_max = std::max(segundos_max, segundos);
+            if (fechas_canonicas) escribir_varint(fechas, zigzag(segundos - segundos_anterior));
+            segundos_anterior = segundos;
+        } else {
+            fechas_canonicas = false;
+        }
+
+        escribir_varint(origenes, indice(t.usuario_origen));
+        escribir_varint(destinos, indice(t.usuario_destino));
+        escribir_varint(tipos, indice(t.tipo));
+        size_t fila = i - desde;
+        if (t.es_sospechosa) sospechosas[fila / 8] |= static_cast<char>(1u << (fila % 8));
+    }
+
+    // Con una sola fecha fuera de formato, la columna entera del bloque va
+    // al diccionario
+    if (!fechas_canonicas) {
+        fechas.assign(1, static_cast<char>(FECHAS_DICCIONARIO));
+        for (size_t i = desde; i < hasta; ++i) escribir_varint(fechas, indice(registros[i].fecha));
+    }
+
+    std::string bloque;
+    for (const std::string* columna : {&ids, &montos, &fechas, &origenes, &destinos, &tipos, &sospechosas}) {
+        escribir_fijo(bloque, columna->size(), 8);
+        bloque += *columna;
+    }
+    return bloque;
+}
+
+// Bloques decodificados recientes de todos los segmentos, por número de
+// segmento y de bloque. Al llenarse sale el usado hace más tiempo; quien
+// todavía lo tenga lo sigue usando. Los de un segmento ya cerrado salen
+// igual, por antigüedad.
+class CacheBloques {
+public:
+    using Clave = std::pair<uint64_t, size_t>;
+
+    std::shared_ptr<const BloqueDecodificado> buscar(const Clave& clave) {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = posiciones.find(clave);
+        if (it == posiciones.end()) return nullptr;
+        recientes.splice(recientes.begin(), recientes, it->second);
+        return it->second->second;
+    }
+
+    void guardar(const Clave& clave, std::shared_ptr<const BloqueDecodificado> bloque) {
+        std::shared_ptr<const BloqueDecodificado> saliente;   // Se libera sin el lock
+        std::lock_guard<std::mutex> lock(mtx);
+        if (posiciones.count(clave)) return;   // Otro hilo lo decodificó a la vez
+        recientes.emplace_front(clave, std::move(bloque));
+        posiciones[clave] = recientes.begin();
+        if (recientes.size() > SegmentoColumnar::BLOQUES_EN_CACHE) {
+            saliente = std::move(recientes.back().second);
+            posiciones.erase(recientes.back().first);
+            recientes.pop_back();
+        }
+    }
+
+private:
+    struct HashClave {
+        size_t operator()(const Clave& clave) const {
+            return std::hash<uint64_t>()(clave.first * 0x9E3779B97F4A7C15ull ^ clave.second);
+        }
+    };
+    using Entrada = std::pair<Clave, std::shared_ptr<const BloqueDecodificado>>;
+
+    std::mutex mtx;
+    std::list<Entrada> recientes;   // Del más reciente al más antiguo
+    std::unordered_map<Clave, std::list<Entrada>::iterator, HashClave> posiciones;
+};
+
+CacheBloques& cache_bloques() {
+    static CacheBloques cache;
+    return cache;
+}
+
+std::atomic<uint64_t> siguiente_numero_segmento{1};
+
+} // namespace
+
+std::string SegmentoColumnar::codificar(const std::vector<TransaccionVista>& registros,
+                                        std::string_view prefijo_log, bool comprimir) {
+    // Diccionario común a usuarios, tipos y fechas no canónicas, en orden
+    // de aparición; las cadenas van con los escapes del log
+    std::vector<std::string_view> diccionario;
+    std::unordered_map<std::string_view, uint32_t> posiciones;
+    auto indice = [&](std::string_view texto) {
+        auto it = posiciones.emplace(texto, static_cast<uint32_t>(diccionario.size()));
+        if (it.second) diccionario.push_back(texto);
+        return it.first->second;
+    };
+
+    std::string bloques, columna_indice;
+    int id_max = 0;
+    for (size_t desde = 0; desde < registros.size(); desde += FILAS_POR_BLOQUE) {
+        size_t hasta = std::min(registros.size(), desde + FILAS_POR_BLOQUE);
+        int minimo = registros[desde].id;
+        int maximo = registros[desde].id;
+        for (size_t i = desde; i < hasta; ++i) {
+            minimo = std::min(minimo, registros[i].id);
+            maximo = std::max(maximo, registros[i].id);
+        }
+        id_max = (desde == 0) ? maximo : std::max(id_max, maximo);
+
+        std::string paquete;
+        int64_t segundos_min = 0, segundos_max = 0;
+        empaquetar(codificar_bloque(registros, desde, hasta, indice, segundos_min, segundos_max),
+                   comprimir, paquete);
+        escribir_varint(columna_indice, hasta - desde);
+        escribir_varint(columna_indice, zigzag(minimo));
+        escribir_varint(columna_indice, zigzag(maximo));
+        escribir_varint(columna_indice, zigzag(segundos_min));
+        escribir_varint(columna_indice, zigzag(segundos_max));
+        escribir_varint(columna_indice, paquete.size());
+        escribir_varint(columna_indice, io_archivos::calcular_crc32(paquete.data(), paquete.size()));
+        bloques += paquete;
+    }
+
+    std::string texto_diccionario;
+    escribir_varint(texto_diccionario, diccionario.size());
+    for (std::string_view texto : diccionario) {
+        escribir_varint(texto_diccionario, texto.size());
+        texto_diccionario.append(texto.data(), texto.size());
+    }
+    std::string columna_diccionario;
+    empaquetar(texto_diccionario, comprimir, columna_diccionario);
+
+    std::string segmento(MAGICO, sizeof(MAGICO));
+    escribir_fijo(segmento, registros.size(), 8);
+    escribir_fijo(segmento, static_cast<uint32_t>(id_max), 4);
+    escribir_fijo(segmento, prefijo_log.size(), 8);
+    escribir_fijo(segmento, io_archivos::calcular_crc32(prefijo_log.data(), prefijo_log.size()), 4);
+    size_t inicio = std::min(prefijo_log.size(), BYTES_INICIO);
+    escribir_fijo(segmento, io_archivos::calcular_crc32(prefijo_log.data(), inicio), 4);
+    escribir_fijo(segmento, FILAS_POR_BLOQUE, 4);
+    for (const std::string* columna : {&columna_diccionario, &columna_indice}) {
+        escribir_fijo(segmento, columna->size(), 8);
+        segmento += *columna;
+    }
+    escribir_fijo(segmento, io_archivos::calcular_crc32(segmento.data(), segmento.size()), 4);
+    segmento += bloques;
+    return segmento;
+}
+
+SegmentoColumnar::SegmentoColumnar(const std::string& ruta)
+    : archivo(ruta), numero(siguiente_numero_segmento++) {
+    std::string_view datos = archivo.contenido();
+    if (datos.size() < LARGO_CABECERA + 4) return;
+
+    const char* cabecera = datos.data() + sizeof(MAGICO);
+    registros = static_cast<size_t>(leer_fijo(cabecera, 8));
+    id_max = static_cast<int>(static_cast<uint32_t>(leer_fijo(cabecera + 8, 4)));
+    largo_prefijo = leer_fijo(cabecera + 12, 8);
+    crc_prefijo = static_cast<uint32_t>(leer_fijo(cabecera + 20, 4));
+    crc_inicio = static_cast<uint32_t>(leer_fijo(cabecera + 24, 4));
+
+    if (std::memcmp(datos.data(), MAGICO, sizeof(MAGICO)) == 0) valido = abrir_por_bloques(datos);
+    if (!valido) bloques.clear();
+}
+
+bool SegmentoColumnar::abrir_por_bloques(std::string_view datos) {
+    // Al abrir solo se comprueban la cabecera y el índice: cada bloque tiene
+    // su CRC, que se verifica al decodificarlo
+    filas_por_bloque = static_cast<size_t>(leer_fijo(datos.data() + LARGO_CABECERA - 4, 4));
+    if (filas_por_bloque == 0) return false;
+
+    LectorBytes lector{datos.data() + LARGO_CABECERA, datos.data() + datos.size()};
+    std::string_view columna_indice;
+    if (!lector.bloque(datos_diccionario) || !lector.bloque(columna_indice) || lector.fin - lector.actual < 4) {
+        return false;
+    }
+    size_t largo = static_cast<size_t>(lector.actual - datos.data());
+    crc_indice = static_cast<uint32_t>(leer_fijo(lector.actual, 4));
+    if (io_archivos::calcular_crc32(datos.data(), largo) != crc_indice) return false;
+    lector.actual += 4;
+
+    LectorBytes indice{columna_indice.data(), columna_indice.data() + columna_indice.size()};
+    size_t fila = 0;
+    while (indice.actual != indice.fin) {
+        uint64_t filas = 0, minimo = 0, maximo = 0, segundos_min = 0, segundos_max = 0, bytes = 0, crc = 0;
+        if (!indice.varint(filas) || !indice.varint(minimo) || !indice.varint(maximo) ||
+            !indice.varint(segundos_min) || !indice.varint(segundos_max) ||
+            !indice.varint(bytes) || !indice.varint(crc) || filas == 0 || filas > filas_por_bloque ||
+            static_cast<uint64_t>(lector.fin - lector.actual) < bytes) {
+            return false;
+        }
+        // Solo el último bloque puede estar incompleto: fila / filas_por_bloque
+        // da el bloque de cada fila
+        if (!bloques.empty() && bloques.back().filas != filas_por_bloque) return false;
+
+        Bloque bloque;
+        bloque.primera_fila = fila;
+        bloque.filas = static_cast<size_t>(filas);
+        bloque.id_min = static_cast<int>(des_zigzag(minimo));
+        bloque.id_max = static_cast<int>(des_zigzag(maximo));
+        bloque.segundos_min = des_zigzag(segundos_min);
+        bloque.segundos_max = des_zigzag(segundos_max);
+        bloque.maximo_acumulado = bloque.segundos_max;
+        if (!bloques.empty()) {
+            bloque.maximo_acumulado = std::max(bloque.maximo_acumulado, bloques.back().maximo_acumulado);
+        }
+        bloque.datos = std::string_view(lector.actual, static_cast<size_t>(bytes));
+        bloque.crc = static_cast<uint32_t>(crc);
+        lector.actual += bytes;
+        fila += bloque.filas;
+        bloques.push_back(bloque);
+    }
+    return fila == registros && lector.actual == lector.fin;
+}
+
+bool SegmentoColumnar::cubre_prefijo(std::string_view log) const {
+    if (!valido || largo_prefijo == 0 || log.size() < largo_prefijo) return false;
+    size_t inicio = std::min(static_cast<size_t>(largo_prefijo), BYTES_INICIO);
+    if (io_archivos::calcular_crc32(log.data(), inicio) != crc_inicio) return false;
+    return io_archivos::calcular_crc32(log.data(), static_cast<size_t>(largo_prefijo)) == crc_prefijo;
+}
+
+bool SegmentoColumnar::verificar() const {
+    if (!valido || !cargar_diccionario()) return false;
+    for (const Bloque& bloque : bloques) {
+        if (!decodificar_bloque(bloque)) return false;
+    }
+    return true;
+}
+
+bool SegmentoColumnar::cargar_diccionario() const {
+    std::call_once(carga_diccionario, [this] { decodificar_diccionario(); });
+    return diccionario_cargado;
+}
+
+std::shared_ptr<const BloqueDecodificado> SegmentoColumnar::obtener_bloque(size_t indice, bool guardar) const {
+    if (!cargar_diccionario()) return nullptr;
+    CacheBloques& cache = cache_bloques();
+    CacheBloques::Clave clave(numero, indice);
+    if (auto guardado = cache.buscar(clave)) return guardado;
+    auto decodificado = decodificar_bloque(bloques[indice]);
+    if (decodificado && guardar) cache.guardar(clave, decodificado);
+    return decodificado;
+}
+
+std::shared_ptr<const BloqueDecodificado> SegmentoColumnar::bloque_de(size_t fila) const {
+    if (!valido || fila >= registros) return nullptr;
+    return obtener_bloque(fila / filas_por_bloque, false);
+}
+
+void SegmentoColumnar::fijar(const std::shared_ptr<const BloqueDecodificado>& bloque,
+                             BloquesDecodificados& decodificados) {
+    if (decodificados.empty() || decodificados.back() != bloque) decodificados.push_back(bloque);
+}
+
+void SegmentoColumnar::decodificar_diccionario() const {
+    std::string_view crudo = datos_diccionario;
+    if (!desempaquetar(datos_diccionario, texto_diccionario, crudo)) return;
+
+    std::vector<std::string_view> entradas;
+    std::vector<bool> escapes;
+    LectorBytes dic{crudo.data(), crudo.data() + crudo.size()};
+    uint64_t cantidad = 0;
+    if (!dic.varint(cantidad)) return;
+    for (uint64_t i = 0; i < cantidad; ++i) {
+        uint64_t largo = 0;
+        if (!dic.varint(largo) || static_cast<uint64_t>(dic.fin - dic.actual) < largo) return;
+        std::string_view texto(dic.actual, static_cast<size_t>(largo));
+        dic.actual += largo;
+        entradas.push_back(texto);
+        escapes.push_back(texto.find('\\') != std::string_view::npos);
+    }
+    diccionario = std::move(entradas);
+    con_escapes = std::move(escapes);
+    diccionario_cargado = true;
+}
+
+std::shared_ptr<const BloqueDecodificado> SegmentoColumnar::decodificar_bloque(const Bloque& bloque) const {
+    std::string almacen;
+    std::string_view crudo = bloque.datos;
+    if (io_archivos::calcular_crc32(bloque.datos.data(), bloque.datos.size()) != bloque.crc ||
+        !desempaquetar(bloque.datos, almacen, crudo)) {
+        return nullptr;
+    }
+
+    LectorBytes lector{crudo.data(), crudo.data() + crudo.size()};
+    std::string_view columnas[COLUMNAS_BLOQUE];
+    for (auto& columna : columnas) {
+        if (!lector.bloque(columna)) return nullptr;
+    }
+    auto lector_de = [](std::string_view columna) {
+        return LectorBytes{columna.data(), columna.data() + columna.size()};
+    };
+    const size_t filas = bloque.filas;
+
+    auto leer_indices = [&](std::string_view columna, std::vector<uint32_t>& destino) {
+        LectorBytes l = lector_de(columna);
+        destino.resize(filas);
+        for (auto& valor : destino) {
+            uint64_t indice;
+            if (!l.varint(indice) || indice >= diccionario.size()) return false;
+            valor = static_cast<uint32_t>(indice);
+        }
+        return true;
+    };
+
+    auto decodificado = std::make_shared<BloqueDecodificado>();
+    BloqueDecodificado& c = *decodificado;
+    c.primera_fila = bloque.primera_fila;
+    c.filas = filas;
+    LectorBytes l_ids = lector_de(columnas[0]);
+    LectorBytes l_montos = lector_de(columnas[1]);
+    int64_t id = 0, centavos = 0;
+    c.ids.resize(filas);
+    c.montos.resize(filas);
+    for (size_t i = 0; i < filas; ++i) {
+        if (!l_ids.delta(id) || !l_montos.delta(centavos)) return nullptr;
+        c.ids[i] = static_cast<int>(id);
+        c.montos[i] = static_cast<double>(centavos) / 100.0;
+    }
+
+    if (columnas[2].empty()) return nullptr;
+    c.segundos.resize(filas);
+    if (columnas[2][0] == FECHAS_SEGUNDOS) {
+        LectorBytes l_fechas = lector_de(columnas[2].substr(1));
+        c.fechas.resize(filas * LARGO_FECHA);
+        int64_t segundos = 0;
+        for (size_t i = 0; i < filas; ++i) {
+            if (!l_fechas.delta(segundos)) return nullptr;
+            c.segundos[i] = segundos;
+            marcas_tiempo::formatear(segundos, &c.fechas[i * LARGO_FECHA]);
+        }
+    } else {
+        if (!leer_indices(columnas[2].substr(1), c.indices_fecha)) return nullptr;
+        for (size_t i = 0; i < filas; ++i) {
+            if (!marcas_tiempo::a_segundos(diccionario[c.indices_fecha[i]], c.segundos[i])) {
+                c.segundos[i] = SIN_FECHA;
+            }
+        }
+    }
+
+    if (!leer_indices(columnas[3], c.origenes) || !leer_indices(columnas[4], c.destinos) ||
+        !leer_indices(columnas[5], c.tipos) || columnas[6].size() != (filas + 7) / 8) {
+        return nullptr;
+    }
+    c.sospechosas.assign(columnas[6].data(), columnas[6].size());
+
+    return decodificado;
+}
+
+TransaccionVista SegmentoColumnar::vista(const BloqueDecodificado& c, size_t fila) const {
+    fila -= c.primera_fila;
+    TransaccionVista t;
+    t.id = c.ids[fila];
+    t.usuario_origen = diccionario[c.origenes[fila]];
+    t.usuario_destino = diccionario[c.destinos[fila]];
+    t.monto = c.montos[fila];
+    t.tipo = diccionario[c.tipos[fila]];
+    t.es_sospechosa = (static_cast<unsigned char>(c.sospechosas[fila / 8]) >> (fila % 8)) & 1u;
+    t.con_escapes = con_escapes[c.origenes[fila]] || con_escapes[c.destinos[fila]] ||
+                    con_escapes[c.tipos[fila]];
+    if (c.indices_fecha.empty()) {
+        t.fecha = std::string_view(c.fechas.data() + fila * LARGO_FECHA, LARGO_FECHA);
+    } else {
+        t.fecha = diccionario[c.indices_fecha[fila]];
+        t.con_escapes = t.con_escapes || con_escapes[c.indices_fecha[fila]];
+    }
+    return t;
+}
+
+bool SegmentoColumnar::vistas_filas(size_t desde, size_t hasta, std::vector<TransaccionVista>& vistas,
+                                    BloquesDecodificados& decodificados) const {
+    if (!valido) return false;
+    hasta = std::min(hasta, registros);
+    if (desde >= hasta) return desde == hasta;
+
+    // Un tramo más largo que la caché se decodifica sin guardarlo en ella
+    size_t primero = desde / filas_por_bloque;
+    size_t ultimo = (hasta - 1) / filas_por_bloque;
+    bool guardar = ultimo - primero < BLOQUES_EN_CACHE;
+    size_t inicio = vistas.size();
+    size_t fijados = decodificados.size();
+    for (size_t b = primero; b <= ultimo; ++b) {
+        auto bloque = obtener_bloque(b, guardar);
+        if (!bloque) {
+            // Todo o nada: sin las filas de este bloque el tramo no sirve
+            vistas.resize(inicio);
+            decodificados.resize(fijados);
+            return false;
+        }
+        fijar(bloque, decodificados);
+        size_t fin = std::min(hasta, bloque->primera_fila + bloque->filas);
+        for (size_t fila = std::max(desde, bloque->primera_fila); fila < fin; ++fila) {
+            vistas.push_back(vista(*bloque, fila));
+        }
+    }
+    return true;
+}
+
+void SegmentoColumnar::vistas_de_usuario(std::string_view nombre, size_t limite,
+                                         std::vector<TransaccionVista>& vistas,
+                                         BloquesDecodificados& decodificados) const {
+    if (!valido || limite == 0 || !cargar_diccionario()) return;
+    auto it = std::find(diccionario.begin(), diccionario.end(), nombre);
+    if (it == diccionario.end()) return;
+
+    // Se compara el índice del diccionario, no el texto, del último bloque
+    // hacia atrás hasta juntar 'limite' filas
+    uint32_t indice = static_cast<uint32_t>(it - diccionario.begin());
+    bool guardar = bloques.size() <= BLOQUES_EN_CACHE;
+    size_t inicio = vistas.size();
+    for (size_t b = bloques.size(); b > 0 && vistas.size() - inicio < limite; --b) {
+        auto bloque = obtener_bloque(b - 1, guardar);
+        if (!bloque) continue;
+        size_t antes = vistas.size();
+        for (size_t i = bloque->filas; i > 0 && vistas.size() - inicio < limite; --i) {
+            if (bloque->origenes[i - 1] == indice || bloque->destinos[i - 1] == indice) {
+                vistas.push_back(vista(*bloque, bloque->primera_fila + i - 1));
+            }
+        }
+        if (vistas.size() > antes) fijar(bloque, decodificados);
+    }
+    std::reverse(vistas.begin() + inicio, vistas.end());
+}
+
+void SegmentoColumnar::vistas_por_id(int desde, int hasta, std::vector<TransaccionVista>& vistas,
+                                     BloquesDecodificados& decodificados) const {
+    if (!valido) return;
+    std::vector<size_t> candidatos;
+    for (size_t b = 0; b < bloques.size(); ++b) {
+        if (bloques[b].id_max >= desde && bloques[b].id_min <= hasta) candidatos.push_back(b);
+    }
+    bool guardar = candidatos.size() <= BLOQUES_EN_CACHE;
+    for (size_t b : candidatos) {
+        auto bloque = obtener_bloque(b, guardar);
+        if (!bloque) continue;
+        size_t antes = vistas.size();
+        for (size_t i = 0; i < bloque->filas; ++i) {
+            int id = bloque->ids[i];
+            if (id >= desde && id <= hasta) vistas.push_back(vista(*bloque, bloque->primera_fila + i));
+        }
+        if (vistas.size() > antes) fijar(bloque, decodificados);
+    }
+}
+
+void SegmentoColumnar::vistas_por_fecha(int64_t desde, int64_t hasta, std::vector<TransaccionVista>& vistas,
+                                        BloquesDecodificados& decodificados) const {
+    if (!valido || desde > hasta) return;
+
+    // Los bloques anteriores al primero cuyo máximo acumulado alcanza
+    // 'desde' tienen todas sus fechas antes del rango
+    auto primero = std::partition_point(bloques.begin(), bloques.end(), [desde](const Bloque& bloque) {
+        return bloque.maximo_acumulado < desde;
+    });
+    std::vector<size_t> candidatos;
+    for (auto it = primero; it != bloques.end(); ++it) {
+        if (it->segundos_max >= desde && it->segundos_min <= hasta) candidatos.push_back(it - bloques.begin());
+    }
+    bool guardar = candidatos.size() <= BLOQUES_EN_CACHE;
+    for (size_t b : candidatos) {
+        auto bloque = obtener_bloque(b, guardar);
+        if (!bloque) continue;
+        size_t antes = vistas.size();
+        const std::vector<int64_t>& segundos = bloque->segundos;
+        for (size_t i = 0; i < bloque->filas; ++i) {
+            if (segundos[i] != SIN_FECHA && segundos[i] >= desde && segundos[i] <= hasta) {
+                vistas.push_back(vista(*bloque, bloque->primera_fila + i));
+            }
+        }
+        if (vistas.size() > antes) fijar(bloque, decodificados);
+    }
+}
+
+bool SegmentoColumnar::recorrer_consulta(const ConsultaTransacciones& consulta,
+                                         const std::function<bool(const TransaccionVista&)>& visitar) const {
+    if (!valido || consulta.desde > consulta.hasta || consulta.id_desde > consulta.id_hasta ||
+        consulta.monto_minimo > consulta.monto_maximo) {
+        return true;
+    }
+    if (!cargar_diccionario()) return true;
+
+    // Las cadenas se pasan a su índice en el diccionario (que guarda el texto
+    // escapado): las filas se comparan por número. Sin índice, ninguna fila.
+    const uint32_t CUALQUIERA = UINT32_MAX;
+    bool presentes = true;
+    auto indice_de = [&](const std::string& texto) {
+        if (texto.empty()) return CUALQUIERA;
+        std::string escapado;
+        SerializadorJSON::escapar(texto, escapado);
+        auto it = std::find(diccionario.begin(), diccionario.end(), escapado);
+        if (it == diccionario.end()) {
+            presentes = false;
+            return CUALQUIERA;
+        }
+        return static_cast<uint32_t>(it - diccionario.begin());
+    };
+    const uint32_t usuario = indice_de(consulta.usuario);
+    const uint32_t origen = indice_de(consulta.origen);
+    const uint32_t destino = indice_de(consulta.destino);
+    const uint32_t tipo = indice_de(consulta.tipo);
+    if (!presentes) return true;
+
+    const bool con_periodo = consulta.desde != INT64_MIN || consulta.hasta != INT64_MAX;
+    auto primero = bloques.begin();
+    if (con_periodo) {
+        primero = std::partition_point(bloques.begin(), bloques.end(), [&](const Bloque& bloque) {
+            return bloque.maximo_acumulado < consulta.desde;
+        });
+    }
+    std::vector<size_t> candidatos;
+    for (auto it = primero; it != bloques.end(); ++it) {
+        if (it->id_max < consulta.id_desde || it->id_min > consulta.id_hasta) continue;
+        if (con_periodo && (it->segundos_max < consulta.desde || it->segundos_min > consulta.hasta)) continue;
+        candidatos.push_back(it - bloques.begin());
+    }
+    bool guardar = candidatos.size() <= BLOQUES_EN_CACHE;
+
+    for (size_t b : candidatos) {
+        auto bloque = obtener_bloque(b, guardar);
+        if (!bloque) continue;
+
+        const BloqueDecodificado& c = *bloque;
+        for (size_t i = 0; i < c.filas; ++i) {
+            if (consulta.es_sospechosa &&
+                (((static_cast<unsigned char>(c.sospechosas[i / 8]) >> (i % 8)) & 1u) != 0) !=
+                    *consulta.es_sospechosa) {
+                continue;
+            }
+            if (c.montos[i] < consulta.monto_minimo || c.montos[i] > consulta.monto_maximo) continue;
+            if (tipo != CUALQUIERA && c.tipos[i] != tipo) continue;
+            if (origen != CUALQUIERA && c.origenes[i] != origen) continue;
+            if (destino != CUALQUIERA && c.destinos[i] != destino) continue;
+            if (usuario != CUALQUIERA && c.origenes[i] != usuario && c.destinos[i] != usuario) continue;
+            if (c.ids[i] < consulta.id_desde || c.ids[i] > consulta.id_hasta) continue;
+            if (con_periodo && (c.segundos[i] == SIN_FECHA || c.segundos[i] < consulta.desde ||
+                                c.segundos[i] > consulta.hasta)) {
+                continue;
+            }
+            if (!visitar(vista(c, c.primera_fila + i))) return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,105 @@
+#include "serializador_json.hpp"
+#include "io_archivos.hpp"
+#include <charconv>
+#include <iomanip>
+#include <locale>
+#include <sstream>
+
+namespace {
+
+const size_t LARGO_CABECERA = 18;   // "%08x %08x "
+
+void escribir_hex(char* destino, uint64_t valor) {
+    static const char digitos[] = "0123456789abcdef";
+    for (int i = 7; i >= 0; --i) {
+        destino[i] = digitos[valor & 0xFu];
+        valor >>= 4;
+    }
+}
+
+} // namespace
+
+void SerializadorJSON::abrir_registro() {
+    // La cabecera se reserva y se completa al cerrar, cuando se conoce el JSON
+    inicio_registro = buffer.size();
+    buffer.append(LARGO_CABECERA, ' ');
+}
+
+void SerializadorJSON::cerrar_registro() {
+    size_t inicio_json = inicio_registro + LARGO_CABECERA;
+    size_t longitud = buffer.size() - inicio_json;
+    uint32_t crc = io_archivos::calcular_crc32(buffer.data() + inicio_json, longitud);
+    escribir_hex(&buffer[inicio_registro], longitud);
+    escribir_hex(&buffer[inicio_registro + 9], crc);
+    buffer += '\n';
+}
+
+void SerializadorJSON::cadena(std::string_view texto) {
+    buffer += '"';
+    escapar(texto, buffer);
+    buffer += '"';
+}
+
+void SerializadorJSON::cadena_escapada(std::string_view texto) {
+    buffer += '"';
+    literal(texto);
+    buffer += '"';
+}
+
+void SerializadorJSON::entero(int64_t valor) {
+    char numero[24];
+    auto r = std::to_chars(numero, numero + sizeof(numero), valor);
+    buffer.append(numero, static_cast<size_t>(r.ptr - numero));
+}
+
+void SerializadorJSON::natural(uint64_t valor) {
+    char numero[24];
+    auto r = std::to_chars(numero, numero + sizeof(numero), valor);
+    buffer.append(numero, static_cast<size_t>(r.ptr - numero));
+}
+
+void SerializadorJSON::monto(double valor) {
+#if !defined(__cpp_lib_to_chars)
+    // to_chars para double llegó en GCC 11 / libc++ 14: antes se usa un
+    // stream con el locale "C" (snprintf seguiría el locale que fija Qt, que
+    // puede tener coma decimal)
+    std::ostringstream numero;
+    numero.imbue(std::locale::classic());
+    numero << std::fixed << std::setprecision(2) << valor;
+    buffer += numero.str();
+#else
+    // El mayor double en notación fija ocupa 309 cifras enteras
+    char numero[400];
+    auto r = std::to_chars(numero, numero + sizeof(numero), valor, std::chars_format::fixed, 2);
+    buffer.append(numero, static_cast<size_t>(r.ptr - numero));
+#endif
+}
+
+void SerializadorJSON::escapar(std::string_view texto, std::string& destino) {
+    // Los tramos sin nada que escapar (casi siempre la cadena entera) se
+    // copian de una vez
+    size_t copiado = 0;
+    for (size_t i = 0; i < texto.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(texto[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+        
+        destino.append(texto.data() + copiado, i - copiado);
+        copiado = i + 1;
+        if (c == '"' || c == '\\') {
+            destino += '\\';
+            destino += static_cast<char>(c);
+        } else if (c == '\n') {
+            destino += "\\n";
+        } else if (c == '\r') {
+            destino += "\\r";
+        } else if (c == '\t') {
+            destino += "\\t";
+        } else {
+            // Ningún carácter de control puede cortar una línea del log
+            static const char digitos[] = "0123456789abcdef";
+            char escape[6] = {'\\', 'u', '0', '0', digitos[c >> 4], digitos[c & 0xFu]};
+            destino.append(escape, sizeof(escape));
+        }
+    }
+    destino.append(texto.data() + copiado, texto.size() - copiado);
+}